@@ -14,78 +14,564 @@
 // }
 
 
-int64_t GetTargetFunctionValue(const std::vector<Edge>& edges,
-                                   const std::vector<int64_t>& flow, 
-                                   int64_t volume) {
-    int64_t value = 0;
+/* Lower bound from the cars alone: every edge needs at least the cars of its low limit 
+   (of its limit, if the cost is negative). */
+int64_t GetCarsLowerBound(const std::vector<Edge>& edges, int64_t volume) {
+    int64_t cars_value = 0;
+    for (const auto& edge : edges) {
+        cars_value += edge.cost * DivideRoundingUp(edge.cost >= 0 ? edge.low_limit : edge.limit, volume);
+    }
+    return cars_value;
+}
+
+
+/* Lower bound of the objective over all flows within the edge bounds, given their LP 
+   optimum flow. Since cost * ceil(f / volume) >= cost * f / volume + min(cost, 0), the 
+   LP value bounds it as well as the cars do. */
+int64_t GetNodeLowerBound(const std::vector<Edge>& edges,
+                          const std::vector<int64_t>& flow, 
+                          int64_t volume) {
+    int64_t lp_value = 0;
+    int64_t lp_correction = 0;
     for (int64_t i = 0; i < int64_t{edges.size()}; ++i) {
-        int64_t cost = edges[i].cost;
-        int64_t cars = (flow[i] + volume - 1) / volume;
-        value += cost * cars; 
+        lp_value += edges[i].cost * flow[i];
+        lp_correction += std::min(edges[i].cost, int64_t{0});
     }
-    return value;
+    return std::max(DivideRoundingUp(lp_value, volume) + lp_correction, GetCarsLowerBound(edges, volume));
+}
+
+
+/* Product of the average down and up bound gains of the edge, the averages over all 
+   edges standing in for a side never branched on. */
+double GetPseudoCostScore(const PseudoCost& pseudo_cost, const PseudoCost& total) {
+    auto average = [](int64_t gain, int64_t count, double fallback) {
+        return count ? static_cast<double>(gain) / static_cast<double>(count) : fallback;
+    };
+    double total_down = average(total.down_gain, total.down_count, 1);
+    double total_up = average(total.up_gain, total.up_count, 1);
+    return std::max(average(pseudo_cost.down_gain, pseudo_cost.down_count, total_down), 1e-6) * 
+           std::max(average(pseudo_cost.up_gain, pseudo_cost.up_count, total_up), 1e-6);
 }
 
+
+/* Edge to branch on and the cars count s splitting it into flow <= s * volume and 
+   flow >= s * volume + 1, so no integer flow is lost. Among the edges whose flow could 
+   drop to fewer cars it takes the best pseudo cost score (weighted by the edge's 
+   priority), then the flow furthest from a whole number of cars; without such edges 
+   the costliest edge whose bounds still allow several cars counts. kNoneValue if there 
+   is none: then every cars count is fixed and the node's flow is optimal for it. */
+std::pair<int64_t, int64_t> GetBranchingEdge(const std::vector<Edge>& edges,
+                                             const std::vector<int64_t>& flow, 
+                                             int64_t volume,
+                                             const std::vector<PseudoCost>& pseudo_costs,
+                                             const PseudoCost& total_pseudo_cost,
+                                             const std::vector<double>& edge_priorities) {
+    int64_t fractional_edge_index = kNoneValue;
+    std::pair<double, int64_t> best_score;
+    int64_t free_edge_index = kNoneValue;
+    for (int64_t i = 0; i < int64_t{edges.size()}; ++i) {
+        int64_t min_cars = DivideRoundingUp(edges[i].low_limit, volume);
+        int64_t max_cars = DivideRoundingUp(edges[i].limit, volume);
+        if (min_cars == max_cars) {
+            continue;
+        }
+
+        if (flow[i] % volume != 0 && min_cars <= flow[i] / volume) {
+            std::pair<double, int64_t> score{GetPseudoCostScore(pseudo_costs[i], total_pseudo_cost) * edge_priorities[i], 
+                                             std::min(flow[i] % volume, volume - flow[i] % volume)};
+            if (fractional_edge_index == kNoneValue || best_score < score) {
+                fractional_edge_index = i;
+                best_score = score;
+            }
+        }
+        if (free_edge_index == kNoneValue || std::abs(edges[free_edge_index].cost) < std::abs(edges[i].cost)) {
+            free_edge_index = i;
+        }
+    }
+
+    if (fractional_edge_index != kNoneValue) {
+        return {fractional_edge_index, flow[fractional_edge_index] / volume};
+    }
+    if (free_edge_index != kNoneValue) {
+        int64_t cars = DivideRoundingUp(flow[free_edge_index], volume);
+        int64_t max_cars = DivideRoundingUp(edges[free_edge_index].limit, volume);
+        return {free_edge_index, cars < max_cars ? cars : cars - 1};
+    }
+    return {kNoneValue, kNoneValue};
+}
+
+
+/* Incumbent shared by the racers of a portfolio solving the same component, and the flag 
+   stopping all of them once one is done. */
+struct Race {
+    std::mutex mutex;
+    std::vector<int64_t> incumbent_flow;
+    std::atomic<int64_t> incumbent_value = std::numeric_limits<int64_t>::max();
+    std::atomic<bool> finished = false;
+};
+
+
+/* Continues the search stored in state, which is kept up to date for the checkpoints 
+   (but for its frontier, written from the queue). A root node already solved (not 
+   null) is opened along with the frontier. A racer (race not null) takes the better 
+   incumbents of the others before every node. */
 std::vector<int64_t> BranchAndBound(const std::vector<Edge>& edges, 
                                     const std::vector<Node>& nodes, 
                                     const std::vector<std::vector<int64_t>>& graph,
-                                    const std::vector<int64_t> flow,
-                                    const std::set<int64_t>& basis_edges,
-                                    int64_t volume) {
-    std::vector<int64_t> best_flow(flow);
-    std::cerr << GetTargetFunctionValue(edges, flow, volume) << std::endl;
-    for (int64_t i = 0; i < int64_t{flow.size()}; ++i) {
-        if (flow[i] % volume == 0) {
+                                    Checkpoint& state,
+                                    int64_t volume,
+                                    const MILPOptions& options,
+                                    std::chrono::steady_clock::time_point deadline,
+                                    BranchNode* root_node,
+                                    Race* race,
+                                    MILPStatistics& statistics) {
+    statistics = MILPStatistics{};
+    statistics.nodes_count = state.nodes_count;
+    int64_t resumed_nodes_count = state.nodes_count;
+    if (options.incumbent_callback) {
+        options.incumbent_callback(state.incumbent_flow, state.incumbent_value);
+    }
+
+    NodeQueue queue(edges, state.root_basis_edges, options.node_queue_bytes, options.node_cache_bytes, 
+                    options.spill_directory);
+    for (auto& node : state.frontier) {
+        queue.Push(std::move(node));
+    }
+    state.frontier.clear();
+
+    PseudoCost total_pseudo_cost;
+    for (const auto& pseudo_cost : state.pseudo_costs) {
+        total_pseudo_cost.down_gain += pseudo_cost.down_gain;
+        total_pseudo_cost.down_count += pseudo_cost.down_count;
+        total_pseudo_cost.up_gain += pseudo_cost.up_gain;
+        total_pseudo_cost.up_count += pseudo_cost.up_count;
+    }
+    std::vector<double> edge_priorities(edges.size(), 1);
+    if (options.branching_seed) {
+        std::mt19937_64 random(options.branching_seed);
+        std::uniform_real_distribution<double> priority(1, 2);
+        for (auto& edge_priority : edge_priorities) {
+            edge_priority = priority(random);
+        }
+    }
+
+    /* Every node LP is a feasible flow, so each one is also tried as the incumbent. */
+    auto bound_node = [&](BranchNode& node) {
+        int64_t value = GetTargetFunctionValue(edges, node.flow, volume);
+        if (value < state.incumbent_value) {
+            state.incumbent_value = value;
+            state.incumbent_flow = node.flow;
+            std::cerr << "incumbent: " << value << " after " << statistics.nodes_count << " nodes" << std::endl;
+            if (options.incumbent_callback) {
+                options.incumbent_callback(state.incumbent_flow, state.incumbent_value);
+            }
+        }
+
+        /* A child keeps the bound of its parent if that one is better. */
+        node.lower_bound = std::max(node.lower_bound, GetNodeLowerBound(node.edges, node.flow, volume));
+        if (options.node_bound == NodeBound::kLagrangian && node.lower_bound < state.incumbent_value) {
+            node.lower_bound = std::max(node.lower_bound, 
+                                        GetLagrangianLowerBound(node.edges, nodes, graph, node.basis_edges, volume, 
+                                                                state.incumbent_value, options.lagrangian_iterations));
+        }
+    };
+    /* Dual method warm started from the node's basis; the flow of a child is still its 
+       parent's one, which the basis was optimal for. Returns false for infeasible nodes. */
+    auto solve_node = [&](BranchNode& node) {
+        node.flow = std::move(DualMethod(node.edges, nodes, graph, node.basis_edges, options.pricing_rule, node.flow));
+        ++statistics.nodes_count;
+        if (!IsFeasibleFlow(node.edges, nodes, node.flow)) {
+            return false;
+        }
+        bound_node(node);
+        return true;
+    };
+    auto push_node = [&](BranchNode& node) {
+        if (node.lower_bound < state.incumbent_value) {
+            queue.Push(std::move(node));
+        }
+    };
+    if (root_node) {
+        bound_node(*root_node);
+        push_node(*root_node);
+    }
+
+    auto checkpoint_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(std::min(options.checkpoint_interval_seconds, 1e9)));
+    auto next_checkpoint_time = std::chrono::steady_clock::now() + checkpoint_interval;
+    auto write_checkpoint = [&] {
+        state.nodes_count = statistics.nodes_count;
+        WriteCheckpoint(options.checkpoint_filename, state, queue.GetFrontierSize(), 
+                        [&queue](std::ostream& file) { queue.WriteFrontier(file); });
+    };
+
+    while (true) {
+        if (race && race->incumbent_value < state.incumbent_value) {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            state.incumbent_value = race->incumbent_value;
+            state.incumbent_flow = race->incumbent_flow;
+        }
+
+        int64_t lower_bound = queue.Empty() ? state.incumbent_value : 
+                                              std::min(queue.GetBestLowerBound(), state.incumbent_value);
+        int64_t best_value = state.incumbent_value;
+        statistics.lower_bound = lower_bound;
+        if (lower_bound == best_value) {
+            statistics.status = MILPStatus::kOptimal;
+            if (race) {
+                race->finished = true;
+            }
+            break;
+        }
+        if (best_value - lower_bound <= options.absolute_gap || 
+            static_cast<double>(best_value - lower_bound) <= options.relative_gap * static_cast<double>(std::abs(best_value))) {
+            statistics.status = MILPStatus::kGapReached;
+            if (race) {
+                race->finished = true;
+            }
+            break;
+        }
+        if (race && race->finished) {
+            /* Stopped by another racer, which reports the outcome. */
+            statistics.status = MILPStatus::kTimeLimit;
+            break;
+        }
+        if (options.node_limit <= statistics.nodes_count - resumed_nodes_count) {
+            statistics.status = MILPStatus::kNodeLimit;
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (deadline <= now) {
+            statistics.status = MILPStatus::kTimeLimit;
+            break;
+        }
+        if (!options.checkpoint_filename.empty() && next_checkpoint_time <= now) {
+            write_checkpoint();
+            next_checkpoint_time = now + checkpoint_interval;
+        }
+
+        BranchNode node = std::move(queue.Pop());
+        if (node.flow.empty() && !solve_node(node)) {
+            continue;
+        }
+        if (state.incumbent_value <= node.lower_bound) {
             continue;
         }
 
-        std::vector<Edge> left_branch_edges(edges);
-        std::set<int64_t> left_branch_basis(basis_edges);
-        left_branch_edges[i].low_limit = (flow[i] / volume + 1) * volume;
-        if (left_branch_edges[i].limit < left_branch_edges[i].low_limit) {
+        auto [edge_index, cars] = GetBranchingEdge(node.edges, node.flow, volume, state.pseudo_costs, total_pseudo_cost, 
+                                                   edge_priorities);
+        if (edge_index == kNoneValue) {
             continue;
         }
-        auto left_branch_flow = DualMethod(left_branch_edges, nodes, graph, left_branch_basis);
+        PseudoCost& pseudo_cost = state.pseudo_costs[edge_index];
 
-        std::vector<Edge> right_branch_edges(edges);
-        std::set<int64_t> right_branch_basis(basis_edges);
-        right_branch_edges[i].limit = (flow[i] / volume) * volume;
-        auto right_branch_flow = DualMethod(right_branch_edges, nodes, graph, right_branch_basis);
+        int64_t parent_lower_bound = node.lower_bound;
 
-        
-        int64_t left_branch_eval = GetTargetFunctionValue(edges, left_branch_flow, volume);
-        int64_t center_branch_eval = GetTargetFunctionValue(edges, flow, volume);
-        int64_t right_branch_eval = GetTargetFunctionValue(edges, right_branch_flow, volume);
+        BranchNode right_branch{node.edges, node.basis_edges, node.flow, parent_lower_bound, node.depth + 1};
+        right_branch.edges[edge_index].limit = cars * volume;
+        if (solve_node(right_branch)) {
+            int64_t gain = right_branch.lower_bound - parent_lower_bound;
+            pseudo_cost.down_gain += gain;
+            total_pseudo_cost.down_gain += gain;
+            ++pseudo_cost.down_count;
+            ++total_pseudo_cost.down_count;
+            push_node(right_branch);
+        }
 
-        if (left_branch_eval < center_branch_eval && left_branch_eval < right_branch_eval) {
-            // std::cerr << "Branch and Bound started on " << i + 1 << " component" << std::endl;
-            // std::cerr << left_branch_edges[i].low_limit << " " << left_branch_edges[i].limit << std::endl;
-            best_flow = BranchAndBound(left_branch_edges, nodes, graph, left_branch_flow, left_branch_basis, volume);
+        BranchNode& left_branch = node;
+        left_branch.edges[edge_index].low_limit = cars * volume + 1;
+        left_branch.depth += 1;
+        if (solve_node(left_branch)) {
+            int64_t gain = left_branch.lower_bound - parent_lower_bound;
+            pseudo_cost.up_gain += gain;
+            total_pseudo_cost.up_gain += gain;
+            ++pseudo_cost.up_count;
+            ++total_pseudo_cost.up_count;
+            push_node(left_branch);
         }
+    }
+
+    if (!options.checkpoint_filename.empty()) {
+        write_checkpoint();
+    }
+    statistics.value = state.incumbent_value;
+    std::cerr << "branch and bound: " << statistics.nodes_count << " nodes, value " << state.incumbent_value 
+              << ", lower bound " << statistics.lower_bound << ", " << queue.GetSpilledNodesCount() 
+              << " nodes spilled to disk (" << queue.GetRestoredNodesCount() << " restored from the LP cache)" << std::endl;
+    return state.incumbent_flow;
+}
+
+
+std::vector<int64_t> RaceConnectedMILP(const std::vector<Edge>& edges, 
+                                       const std::vector<Node>& nodes, 
+                                       const std::vector<std::vector<int64_t>>& graph,
+                                       int64_t volume,
+                                       const MILPOptions& options,
+                                       std::chrono::steady_clock::time_point deadline,
+                                       MILPStatistics& statistics);
+
 
-        if (center_branch_eval < left_branch_eval && center_branch_eval < right_branch_eval) {
-            // std::cerr << "Branch and Bound started on " << i + 1 << " component" << std::endl;
-            // std::cerr << left_branch_edges[i].low_limit << " " << left_branch_edges[i].limit << std::endl;
-            best_flow = flow;
-            // best_flow = BranchAndBound(edges, nodes, graph, flow, basis_edges, volume);
+/* Branch and bound of a connected network, as a racer of the portfolio if race is not 
+   null and as the whole portfolio if the options ask for several racers. */
+std::vector<int64_t> SolveConnectedMILP(const std::vector<Edge>& edges, 
+                                        const std::vector<Node>& nodes, 
+                                        const std::vector<std::vector<int64_t>>& graph,
+                                        int64_t volume,
+                                        const MILPOptions& options,
+                                        std::chrono::steady_clock::time_point deadline,
+                                        Race* race,
+                                        MILPStatistics& statistics) {
+    if (options.graph_order != GraphOrder::kInput) {
+        std::vector<Subproblem> reordered;
+        reordered.push_back(ReorderGraph(edges, nodes, graph, options.graph_order));
+        MILPOptions reordered_options(options);
+        reordered_options.graph_order = GraphOrder::kInput;
+        if (options.incumbent_callback) {
+            reordered_options.incumbent_callback = [&](const std::vector<int64_t>& flow, int64_t value) {
+                options.incumbent_callback(MergeFlows(reordered, {flow}, static_cast<int64_t>(edges.size())), 
+                                           value);
+            };
         }
+        std::vector<std::vector<int64_t>> flows{SolveConnectedMILP(reordered[0].edges, reordered[0].nodes, reordered[0].graph, 
+                                                                   volume, reordered_options, deadline, race, statistics)};
+        return MergeFlows(reordered, flows, static_cast<int64_t>(edges.size()));
+    }
+    if (1 < options.portfolio_size) {
+        return RaceConnectedMILP(edges, nodes, graph, volume, options, deadline, statistics);
+    }
+
+    Checkpoint state;
+    BranchNode root_node;
+    bool root_solved = false;
+    if (options.resume && std::filesystem::exists(options.checkpoint_filename)) {
+        state = std::move(ReadCheckpoint(options.checkpoint_filename, edges, nodes, volume));
+        std::cerr << "resuming from " << options.checkpoint_filename << ": " << state.frontier.size() 
+                  << " open nodes, incumbent " << state.incumbent_value << std::endl;
+    } else {
+        auto [initial_flow, basis_edges] = std::move(options.root_engine == LPEngine::kCapacityScaling ?
+                                                     GetOptimalFlowCapacityScaling(edges, nodes, graph) :
+                                                     options.root_engine == LPEngine::kPrimalSimplex ?
+                                                     GetOptimalFlow(edges, nodes, graph) :
+                                                     GetInitialFlow(edges, nodes, graph));
+        state.network_fingerprint = GetNetworkFingerprint(edges, nodes, volume);
+        state.incumbent_value = GetTargetFunctionValue(edges, initial_flow, volume);
+        state.incumbent_flow = std::move(initial_flow);
+        state.root_basis_edges = std::move(basis_edges);
+        state.pseudo_costs.resize(edges.size());
+        if (options.root_engine == LPEngine::kNetworkSimplex) {
+            state.frontier.push_back({GetCarsLowerBound(edges, volume), 0, {}});
+        } else {
+            /* The other engines return the optimal root LP, so the dual method does not 
+               solve it again. */
+            root_node = BranchNode{edges, state.root_basis_edges, state.incumbent_flow, GetCarsLowerBound(edges, volume), 0};
+            root_solved = true;
+            state.nodes_count = 1;
+        }
+    }
+
+    return BranchAndBound(edges, nodes, graph, state, volume, options, deadline, 
+                          root_solved ? &root_node : nullptr, race, statistics);
+}
+
+
+/* Racer k of the portfolio: the root engines, pricing rules and branching seeds are 
+   taken in turn starting from the ones of the options. */
+MILPOptions GetRacerOptions(const MILPOptions& options, int64_t racer) {
+    MILPOptions racer_options(options);
+    racer_options.portfolio_size = 1;
+    racer_options.root_engine = static_cast<LPEngine>(
+        (static_cast<int64_t>(options.root_engine) + racer) % kLPEnginesCount);
+    racer_options.pricing_rule = static_cast<DualPricingRule>(
+        (static_cast<int64_t>(options.pricing_rule) + racer) % kDualPricingRulesCount);
+    racer_options.branching_seed = options.branching_seed + racer;
+    racer_options.node_cache_bytes = options.node_cache_bytes / options.portfolio_size;
+    racer_options.node_queue_bytes = options.node_queue_bytes / options.portfolio_size;
+    if (!options.checkpoint_filename.empty()) {
+        racer_options.checkpoint_filename = options.checkpoint_filename + ".r" + std::to_string(racer);
+    }
+    return racer_options;
+}
 
-        if (right_branch_eval < left_branch_eval && right_branch_eval < center_branch_eval) {
-            // std::cerr << "Branch and Bound started on " << i + 1 << " component" << std::endl;
-            // std::cerr << left_branch_edges[i].low_limit << " " << left_branch_edges[i].limit << std::endl;
 
-            best_flow = BranchAndBound(right_branch_edges, nodes, graph, right_branch_flow, right_branch_basis, volume);
+/* Every racer reports its incumbents to the race, which passes the improving ones on to 
+   the callback of the options. The statistics are the best of the racers: their proven 
+   lower bounds all hold for the shared incumbent. */
+std::vector<int64_t> RaceConnectedMILP(const std::vector<Edge>& edges, 
+                                       const std::vector<Node>& nodes, 
+                                       const std::vector<std::vector<int64_t>>& graph,
+                                       int64_t volume,
+                                       const MILPOptions& options,
+                                       std::chrono::steady_clock::time_point deadline,
+                                       MILPStatistics& statistics) {
+    Race race;
+    std::vector<MILPStatistics> racers_statistics(options.portfolio_size);
+    std::vector<std::exception_ptr> errors(options.portfolio_size);
+    auto run_racer = [&](int64_t racer) {
+        MILPOptions racer_options = std::move(GetRacerOptions(options, racer));
+        racer_options.incumbent_callback = [&](const std::vector<int64_t>& flow, int64_t value) {
+            std::lock_guard<std::mutex> lock(race.mutex);
+            if (value < race.incumbent_value) {
+                race.incumbent_flow = flow;
+                race.incumbent_value = value;
+                if (options.incumbent_callback) {
+                    options.incumbent_callback(flow, value);
+                }
+            }
+        };
+        try {
+            SolveConnectedMILP(edges, nodes, graph, volume, racer_options, deadline, &race, racers_statistics[racer]);
+        } catch (...) {
+            errors[racer] = std::current_exception();
+            race.finished = true;
         }
+    };
+
+    std::vector<std::thread> racers;
+    for (int64_t i = 1; i < options.portfolio_size; ++i) {
+        racers.emplace_back(run_racer, i);
+    }
+    run_racer(0);
+    for (auto& racer : racers) {
+        racer.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    statistics = MILPStatistics{MILPStatus::kTimeLimit, race.incumbent_value, std::numeric_limits<int64_t>::min(), 0};
+    for (int64_t i = 0; i < options.portfolio_size; ++i) {
+        std::cerr << "racer " << i << ": " << racers_statistics[i].nodes_count << " nodes, lower bound " 
+                  << racers_statistics[i].lower_bound << std::endl;
+        statistics.status = std::min(statistics.status, racers_statistics[i].status);
+        statistics.lower_bound = std::max(statistics.lower_bound, racers_statistics[i].lower_bound);
+        statistics.nodes_count += racers_statistics[i].nodes_count;
     }
-    std::cerr << "result eval of branch and bound: " << GetTargetFunctionValue(edges, best_flow, volume) << std::endl;
-    return best_flow;
+    if (statistics.value <= statistics.lower_bound) {
+        statistics.status = MILPStatus::kOptimal;
+        statistics.lower_bound = statistics.value;
+    }
+    return race.incumbent_flow;
 }
 
 
 std::vector<int64_t> SolveMILP(const std::vector<Edge>& edges, 
                                const std::vector<Node>& nodes, 
                                const std::vector<std::vector<int64_t>>& graph,
-                               int64_t volume) {
-    auto [initial_flow, basis_edges] = std::move(GetInitialFlow(edges, nodes, graph));
-    return BranchAndBound(edges, nodes, graph, initial_flow, basis_edges, volume);
+                               int64_t volume,
+                               const MILPOptions& options,
+                               MILPStatistics* statistics) {
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (options.time_limit_seconds < std::numeric_limits<double>::infinity()) {
+        deadline = std::chrono::steady_clock::now() + 
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(options.time_limit_seconds));
+    }
+    MILPStatistics local_statistics;
+    if (!statistics) {
+        statistics = &local_statistics;
+    }
+
+    auto subproblems = std::move(SplitIntoComponents(edges, nodes, graph));
+    if (subproblems.size() == 1 && subproblems[0].vertices.size() == graph.size()) {
+        return SolveConnectedMILP(edges, nodes, graph, volume, options, deadline, nullptr, *statistics);
+    }
+    std::cerr << "network splits into " << subproblems.size() << " components" << std::endl;
+
+    /* The incumbent of the whole network is merged from the latest incumbents of the 
+       components, once each of them has one. */
+    std::mutex incumbents_mutex;
+    std::vector<std::vector<int64_t>> incumbents(subproblems.size());
+    std::vector<int64_t> incumbent_values(subproblems.size(), kNoneValue);
+    int64_t incumbents_count = 0;
+    auto report_incumbent = [&](int64_t component, const std::vector<int64_t>& flow, int64_t value) {
+        std::lock_guard<std::mutex> lock(incumbents_mutex);
+        incumbents_count += incumbents[component].empty();
+        incumbents[component] = flow;
+        incumbent_values[component] = value;
+        if (incumbents_count == static_cast<int64_t>(subproblems.size())) {
+            options.incumbent_callback(MergeFlows(subproblems, incumbents, static_cast<int64_t>(edges.size())), 
+                                       std::accumulate(incumbent_values.begin(), incumbent_values.end(), int64_t{0}));
+        }
+    };
+
+    /* Components are independent, so each gets its own branch and bound and a share of 
+       the node cache and queue budgets proportional to its edges. Workers take the 
+       largest ones first, and a component gets the share of the remaining time its 
+       edges have among the components left for its worker. */
+    std::vector<std::vector<int64_t>> flows(subproblems.size());
+    std::vector<MILPStatistics> components_statistics(subproblems.size());
+    std::vector<std::exception_ptr> errors(subproblems.size());
+    int64_t workers_count = std::min(options.threads_count, static_cast<int64_t>(subproblems.size()));
+    std::mutex components_mutex;
+    int64_t next_component = 0;
+    int64_t remaining_edges_count = static_cast<int64_t>(edges.size());
+    auto solve_components = [&] {
+        while (true) {
+            int64_t i;
+            auto component_deadline = deadline;
+            {
+                std::lock_guard<std::mutex> lock(components_mutex);
+                if (next_component == static_cast<int64_t>(subproblems.size())) {
+                    return;
+                }
+                i = next_component++;
+                auto now = std::chrono::steady_clock::now();
+                int64_t component_edges_count = static_cast<int64_t>(subproblems[i].edges.size());
+                double share = static_cast<double>(workers_count * component_edges_count) / 
+                               static_cast<double>(std::max(remaining_edges_count, int64_t{1}));
+                if (share < 1 && now < deadline && deadline != std::chrono::steady_clock::time_point::max()) {
+                    component_deadline = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>((deadline - now) * share);
+                }
+                remaining_edges_count -= component_edges_count;
+            }
+
+            const Subproblem& subproblem = subproblems[i];
+            MILPOptions component_options(options);
+            int64_t edges_count = std::max(static_cast<int64_t>(edges.size()), int64_t{1});
+            component_options.node_cache_bytes = options.node_cache_bytes / edges_count * 
+                                                 static_cast<int64_t>(subproblem.edges.size());
+            component_options.node_queue_bytes = options.node_queue_bytes / edges_count * 
+                                                 static_cast<int64_t>(subproblem.edges.size());
+            if (!options.checkpoint_filename.empty()) {
+                component_options.checkpoint_filename = options.checkpoint_filename + "." + std::to_string(i);
+            }
+            if (options.incumbent_callback) {
+                component_options.incumbent_callback = [&report_incumbent, i](const std::vector<int64_t>& flow, int64_t value) {
+                    report_incumbent(i, flow, value);
+                };
+            }
+            try {
+                flows[i] = SolveConnectedMILP(subproblem.edges, subproblem.nodes, subproblem.graph, 
+                                              volume, component_options, component_deadline, nullptr, 
+                                              components_statistics[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int64_t i = 1; i < workers_count; ++i) {
+        workers.emplace_back(solve_components);
+    }
+    solve_components();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    *statistics = MILPStatistics{};
+    for (const auto& component_statistics : components_statistics) {
+        statistics->status = std::max(statistics->status, component_statistics.status);
+        statistics->value += component_statistics.value;
+        statistics->lower_bound += component_statistics.lower_bound;
+        statistics->nodes_count += component_statistics.nodes_count;
+    }
+    return MergeFlows(subproblems, flows, static_cast<int64_t>(edges.size()));
 }
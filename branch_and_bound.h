@@ -4,15 +4,114 @@
 #include "utility.h"
 #include "direct_method.h"
 #include "dual_method.h"
+#include "capacity_scaling.h"
+#include "node_cache.h"
+#include "presolve.h"
+#include "checkpoint.h"
+#include "node_queue.h"
+#include "lagrangian.h"
 #include <bits/stdc++.h>
 
 
-int64_t GetTargetFunctionValue(const std::vector<Edge>& edges,
-                               const std::vector<int64_t>& flow, 
-                               int64_t volume);
+/* Engine solving the root relaxation of SolveMILP. */
+enum class LPEngine {
+    kNetworkSimplex,    // GetInitialFlow, phase one of the network simplex
+    kCapacityScaling,   // GetOptimalFlowCapacityScaling, for very large networks
+    kPrimalSimplex,     // GetOptimalFlow, both phases of the primal network simplex
+};
+const int64_t kLPEnginesCount = 3;
 
 
+/* Lower bound of the branch and bound nodes, used to prune them. */
+enum class NodeBound {
+    kLinearRelaxation,  // the LP with unit costs and the cars of the edge bounds
+    kLagrangian,        // the same, raised by GetLagrangianLowerBound when it does not prune
+};
+
+
+struct MILPOptions {
+    LPEngine root_engine = LPEngine::kNetworkSimplex;
+    /* Memory budget in bytes of the LPs kept for the open nodes spilled to disk (see 
+       NodeCache), 0 turns it off. The search splits every node into disjoint children, 
+       so a bound set comes up again only when a spilled node is paged back in; without 
+       spilling the cache never hits. Off by default, since it keeps in memory the flows 
+       spilling has just freed. */
+    int64_t node_cache_bytes = 0;
+    /* Memory budget of the open nodes in bytes, beyond it the worse ones are spilled to 
+       a log file in spill_directory (the system temporary directory if empty). */
+    int64_t node_queue_bytes = int64_t{1} << 30;
+    std::string spill_directory;
+
+    /* Rule of the dual method re-solving the node LPs. */
+    DualPricingRule pricing_rule = DualPricingRule::kLargestInfeasibility;
+    /* A nonzero seed randomly weights the branching preferences of the edges, breaking 
+       their ties differently. */
+    uint64_t branching_seed = 0;
+
+    NodeBound node_bound = NodeBound::kLinearRelaxation;
+    /* Subgradient steps per node with NodeBound::kLagrangian. */
+    int64_t lagrangian_iterations = 50;
+    /* Threads solving independent connected components at the same time. */
+    int64_t threads_count = 1;
+    /* Relabeling of every component before it is solved, reversed in the result. */
+    GraphOrder graph_order = GraphOrder::kInput;
+    /* Racers solving every connected component at the same time, each on its own thread. 
+       Racer k takes the root engine, pricing rule and branching seed k places after the 
+       ones above (racer 0 keeps them), and a share of the cache and queue budgets. They 
+       share the incumbent and all stop once one of them proves optimality or reaches the 
+       gap; a racer still solving its root LP is waited for. With checkpoints each racer 
+       gets its own file, the name suffixed by ".r<racer index>". */
+    int64_t portfolio_size = 1;
+
+    /* The search stops at the first limit reached and returns its incumbent. The node 
+       limit and the gaps apply to every connected component on its own, the time limit 
+       to the whole call. The node limit counts the nodes solved by this call only, not 
+       those a resumed checkpoint had already solved (the statistics count both). The 
+       gaps compare the incumbent value with the proven lower bound. */
+    double time_limit_seconds = std::numeric_limits<double>::infinity();
+    int64_t node_limit = std::numeric_limits<int64_t>::max();
+    double relative_gap = 0;
+    int64_t absolute_gap = 0;
+
+    /* Called with every improving incumbent (a feasible flow of the whole network and 
+       its value) while the search goes on. With several components it is called once 
+       every component has an incumbent, possibly from different threads, but never 
+       concurrently. */
+    std::function<void(const std::vector<int64_t>&, int64_t)> incumbent_callback;
+
+    /* Checkpoint of the search, written every checkpoint_interval_seconds and when it 
+       stops (empty name: never). With several components each gets its own file, the 
+       name suffixed by ".<component index>". With resume a search whose checkpoint file 
+       exists continues from it instead of starting at the root. */
+    std::string checkpoint_filename;
+    double checkpoint_interval_seconds = 60;
+    bool resume = false;
+};
+
+
+/* Why the search stopped, from best to worst; merged components report the worst. */
+enum class MILPStatus {
+    kOptimal,
+    kGapReached,
+    kNodeLimit,
+    kTimeLimit,
+};
+
+
+struct MILPStatistics {
+    MILPStatus status = MILPStatus::kOptimal;
+    int64_t value = 0;          // value of the returned flow
+    int64_t lower_bound = 0;    // proven lower bound of the optimal value
+    int64_t nodes_count = 0;    // branch and bound nodes whose LP was solved, resumed ones included
+};
+
+
+/* The network is split into connected components first, each one is solved on its own 
+   and the flows are merged back. Returns the best flow found, statistics (if not null) 
+   gets its value and the proven lower bound. */
 std::vector<int64_t> SolveMILP(const std::vector<Edge>& edges, 
                                const std::vector<Node>& nodes, 
                                const std::vector<std::vector<int64_t>>& graph,
-                               int64_t volume);
+                               int64_t volume,
+                               const MILPOptions& options = {},
+                               MILPStatistics* statistics = nullptr);
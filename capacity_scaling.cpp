@@ -0,0 +1,357 @@
+#include "capacity_scaling.h"
+
+
+/* Residual arcs: 2 * edge_index goes along the edge, 2 * edge_index + 1 against it. */
+int64_t GetResidualCapacity(const std::vector<Edge>& edges, 
+                            const std::vector<int64_t>& flow, 
+                            int64_t arc) {
+    int64_t edge_index = arc >> 1;
+    if (arc & 1) {
+        return flow[edge_index] - edges[edge_index].low_limit;
+    }
+    return edges[edge_index].limit - flow[edge_index];
+}
+
+
+int64_t GetReducedCost(const std::vector<Edge>& edges, 
+                       const std::vector<int64_t>& potentials, 
+                       int64_t arc) {
+    const Edge& edge = edges[arc >> 1];
+    int64_t reduced_cost = edge.cost + potentials[edge.from] - potentials[edge.to];
+    return (arc & 1) ? -reduced_cost : reduced_cost;
+}
+
+
+void PushFlow(const std::vector<Edge>& edges, 
+              std::vector<int64_t>& flow, 
+              std::vector<int64_t>& excess, 
+              int64_t arc, 
+              int64_t value) {
+    int64_t edge_index = arc >> 1;
+    flow[edge_index] += (arc & 1) ? -value : value;
+
+    int64_t tail = edges[edge_index].from;
+    int64_t head = edges[edge_index].to;
+    if (arc & 1) {
+        std::swap(tail, head);
+    }
+    excess[tail] -= value;
+    excess[head] += value;
+}
+
+
+/* Dijkstra on reduced costs from all vertices with excess of at least delta over the 
+   delta-residual network, stopped once every reachable vertex with deficit of at least 
+   delta is settled. Potentials become potentials + min(distance, D) - D, where D is the 
+   distance to the farthest of those deficits, so shortest paths to all of them consist 
+   of zero reduced cost arcs. Returns false if no deficit is reachable. */
+bool UpdatePotentials(const std::vector<Edge>& edges, 
+                      const std::vector<std::vector<int64_t>>& graph,
+                      const std::vector<int64_t>& flow,
+                      const std::vector<int64_t>& excess,
+                      int64_t delta,
+                      std::vector<int64_t>& potentials) {
+    const int64_t kInfinity = std::numeric_limits<int64_t>::max();
+    std::vector<int64_t> distance(graph.size(), kInfinity);
+    std::vector<int64_t> settled;
+    std::priority_queue<std::pair<int64_t, int64_t>, 
+                        std::vector<std::pair<int64_t, int64_t>>, 
+                        std::greater<>> queue;
+
+    int64_t deficits_cnt = 0;
+    for (int64_t vertex = 0; vertex < static_cast<int64_t>(graph.size()); ++vertex) {
+        if (excess[vertex] >= delta) {
+            distance[vertex] = 0;
+            queue.emplace(0, vertex);
+        }
+        if (excess[vertex] <= -delta) {
+            ++deficits_cnt;
+        }
+    }
+
+    int64_t max_distance = kNoneValue;
+    while (!queue.empty() && deficits_cnt) {
+        auto [vertex_distance, vertex] = queue.top();
+        queue.pop();
+        if (vertex_distance != distance[vertex]) {
+            continue;
+        }
+        settled.push_back(vertex);
+        if (excess[vertex] <= -delta) {
+            max_distance = vertex_distance;
+            --deficits_cnt;
+        }
+
+        for (auto edge_index : graph[vertex]) {
+            const Edge& edge = edges[edge_index];
+            int64_t arc = 2 * edge_index + (edge.from == vertex ? 0 : 1);
+            int64_t next = vertex ^ edge.from ^ edge.to;
+            if (GetResidualCapacity(edges, flow, arc) < delta) {
+                continue;
+            }
+
+            int64_t next_distance = vertex_distance + GetReducedCost(edges, potentials, arc);
+            if (next_distance < distance[next]) {
+                distance[next] = next_distance;
+                queue.emplace(next_distance, next);
+            }
+        }
+    }
+
+    if (max_distance == kNoneValue) {
+        return false;
+    }
+    for (auto vertex : settled) {
+        potentials[vertex] += distance[vertex] - max_distance;
+    }
+    return true;
+}
+
+
+/* Blocking flow over the admissible network (delta-residual arcs with zero reduced cost)
+   from vertices with excess to vertices with deficit of at least delta. Pushing along zero 
+   reduced cost arcs keeps the reduced costs of the delta-residual network nonnegative, so 
+   paths carry as much as they can, not just delta. */
+void AugmentAdmissiblePaths(const std::vector<Edge>& edges, 
+                            const std::vector<std::vector<int64_t>>& graph,
+                            const std::vector<int64_t>& potentials,
+                            int64_t delta,
+                            std::vector<int64_t>& flow,
+                            std::vector<int64_t>& excess) {
+    std::vector<int64_t> current_arc(graph.size(), 0);
+    std::vector<bool> on_path(graph.size(), false);
+    std::vector<int64_t> path;
+
+    for (int64_t source = 0; source < static_cast<int64_t>(graph.size()); ++source) {
+        int64_t vertex = source;
+        on_path[source] = true;
+        while (excess[source] >= delta) {
+            if (excess[vertex] <= -delta) {
+                int64_t value = std::min(excess[source], -excess[vertex]);
+                for (auto arc : path) {
+                    value = std::min(value, GetResidualCapacity(edges, flow, arc));
+                }
+                for (auto arc : path) {
+                    PushFlow(edges, flow, excess, arc, value);
+                }
+                for (auto arc : path) {
+                    on_path[edges[arc >> 1].from] = on_path[edges[arc >> 1].to] = false;
+                }
+                path.clear();
+                vertex = source;
+                on_path[source] = true;
+                continue;
+            }
+
+            int64_t next = kNoneValue;
+            for (; current_arc[vertex] < static_cast<int64_t>(graph[vertex].size()); ++current_arc[vertex]) {
+                int64_t edge_index = graph[vertex][current_arc[vertex]];
+                const Edge& edge = edges[edge_index];
+                int64_t arc = 2 * edge_index + (edge.from == vertex ? 0 : 1);
+                int64_t candidate = vertex ^ edge.from ^ edge.to;
+                if (!on_path[candidate] && 
+                    GetResidualCapacity(edges, flow, arc) >= delta && 
+                    GetReducedCost(edges, potentials, arc) == 0) {
+                    next = candidate;
+                    path.push_back(arc);
+                    break;
+                }
+            }
+
+            if (next != kNoneValue) {
+                on_path[next] = true;
+                vertex = next;
+                continue;
+            }
+            if (path.empty()) {
+                break;
+            }
+
+            /* Dead end: retreat and never come back through it in this round. */
+            on_path[vertex] = false;
+            int64_t arc = path.back();
+            path.pop_back();
+            vertex ^= edges[arc >> 1].from ^ edges[arc >> 1].to;
+            ++current_arc[vertex];
+        }
+        for (auto arc : path) {
+            on_path[edges[arc >> 1].from] = on_path[edges[arc >> 1].to] = false;
+        }
+        path.clear();
+        on_path[source] = false;
+    }
+}
+
+
+void CapacityScalingMethod(const std::vector<Edge>& edges, 
+                           const std::vector<Node>& nodes, 
+                           const std::vector<std::vector<int64_t>>& graph,
+                           std::vector<int64_t>& flow,
+                           std::vector<int64_t>& potentials) {
+    if (nodes.empty()) { 
+        throw "Empty nodes.\n";
+    }
+
+    flow.assign(edges.size(), 0);
+    potentials.assign(nodes.size(), 0);
+
+    std::vector<int64_t> excess(nodes.size(), 0);
+    for (const auto& node : nodes) {
+        excess[node.vertex] += node.production;
+    }
+
+    int64_t max_value = 1;
+    for (int64_t edge_index = 0; edge_index < static_cast<int64_t>(edges.size()); ++edge_index) {
+        if (edges[edge_index].limit < edges[edge_index].low_limit) {
+            throw "No solution can be find.\n";
+        }
+        flow[edge_index] = edges[edge_index].low_limit;
+        excess[edges[edge_index].from] -= flow[edge_index];
+        excess[edges[edge_index].to] += flow[edge_index];
+        max_value = std::max(max_value, edges[edge_index].limit - edges[edge_index].low_limit);
+    }
+    for (auto value : excess) {
+        max_value = std::max(max_value, std::abs(value));
+    }
+
+    int64_t delta = 1;
+    while (delta <= max_value / 2) {
+        delta *= 2;
+    }
+
+    for (; delta >= 1; delta /= 2) {
+        /* Restoring nonnegative reduced costs on the delta-residual network. */
+        for (int64_t arc = 0; arc < 2 * static_cast<int64_t>(edges.size()); ++arc) {
+            int64_t capacity = GetResidualCapacity(edges, flow, arc);
+            if (capacity >= delta && GetReducedCost(edges, potentials, arc) < 0) {
+                PushFlow(edges, flow, excess, arc, capacity);
+            }
+        }
+
+        while (UpdatePotentials(edges, graph, flow, excess, delta, potentials)) {
+            AugmentAdmissiblePaths(edges, graph, potentials, delta, flow, excess);
+        }
+    }
+
+    for (auto value : excess) {
+        if (value) {
+            std::cerr << "capacity_scaling.cpp/Network does not allow the flow." << std::endl;
+            throw "No solution can be find.\n";
+        }
+    }
+
+    int64_t root_potential = potentials[0];
+    for (auto& potential : potentials) {
+        potential -= root_potential;
+    }
+}
+
+
+int64_t FindComponent(std::vector<int64_t>& component, int64_t vertex) {
+    while (component[vertex] != vertex) {
+        component[vertex] = component[component[vertex]];
+        vertex = component[vertex];
+    }
+    return vertex;
+}
+
+
+std::set<int64_t> GetBasisFromPotentials(const std::vector<Edge>& edges, 
+                                         const std::vector<Node>& nodes, 
+                                         const std::vector<int64_t>& flow,
+                                         const std::vector<int64_t>& potentials) {
+    std::vector<int64_t> component(nodes.size());
+    std::iota(component.begin(), component.end(), 0);
+    std::set<int64_t> basis_edges;
+    std::vector<int64_t> shifted_potentials(potentials);
+
+    auto try_add = [&](int64_t edge_index) {
+        int64_t u = FindComponent(component, edges[edge_index].from);
+        int64_t v = FindComponent(component, edges[edge_index].to);
+        if (u != v) {
+            component[u] = v;
+            basis_edges.insert(edge_index);
+        }
+    };
+    auto get_reduced_cost = [&](int64_t edge_index) {
+        const Edge& edge = edges[edge_index];
+        return edge.cost + shifted_potentials[edge.from] - shifted_potentials[edge.to];
+    };
+
+    for (int64_t edge_index = 0; edge_index < static_cast<int64_t>(edges.size()); ++edge_index) {
+        if (edges[edge_index].low_limit < flow[edge_index] && flow[edge_index] < edges[edge_index].limit) {
+            try_add(edge_index);
+        }
+    }
+    for (int64_t edge_index = 0; edge_index < static_cast<int64_t>(edges.size()); ++edge_index) {
+        if (get_reduced_cost(edge_index) == 0) {
+            try_add(edge_index);
+        }
+    }
+
+    /* Shifting the potentials of a whole component by delta keeps the edges inside it 
+       tight and changes the reduced cost of a crossing edge by +delta (leaving the 
+       component) or -delta (entering it). The shift stays within what keeps every 
+       crossing edge optimal for its bound and makes the nearest one tight. */
+    while (static_cast<int64_t>(basis_edges.size()) + 1 < static_cast<int64_t>(nodes.size())) {
+        int64_t shifted_component = FindComponent(component, 0);
+        int64_t min_upper_delta = std::numeric_limits<int64_t>::max();
+        int64_t max_lower_delta = std::numeric_limits<int64_t>::min();
+        int64_t fixed_edge_delta = kNoneValue;
+        bool has_crossing_edge = false;
+        for (int64_t edge_index = 0; edge_index < static_cast<int64_t>(edges.size()); ++edge_index) {
+            const Edge& edge = edges[edge_index];
+            bool from_inside = FindComponent(component, edge.from) == shifted_component;
+            bool to_inside = FindComponent(component, edge.to) == shifted_component;
+            if (from_inside == to_inside) {
+                continue;
+            }
+            int64_t tight_delta = from_inside ? -get_reduced_cost(edge_index) : get_reduced_cost(edge_index);
+            bool at_lower = flow[edge_index] == edge.low_limit;
+            bool at_upper = flow[edge_index] == edge.limit;
+            if (at_lower && at_upper) {
+                /* Fixed edges are optimal with any reduced cost. */
+                if (!has_crossing_edge) {
+                    fixed_edge_delta = tight_delta;
+                }
+            } else if (at_lower != from_inside) {
+                /* The reduced cost must stay >= 0 at the lower bound, <= 0 at the upper one. */
+                min_upper_delta = std::min(min_upper_delta, tight_delta);
+            } else {
+                max_lower_delta = std::max(max_lower_delta, tight_delta);
+            }
+            has_crossing_edge = true;
+        }
+        if (!has_crossing_edge) {
+            break;
+        }
+        int64_t delta = min_upper_delta != std::numeric_limits<int64_t>::max() ? min_upper_delta :
+                        max_lower_delta != std::numeric_limits<int64_t>::min() ? max_lower_delta : 
+                        fixed_edge_delta;
+        for (int64_t vertex = 0; vertex < static_cast<int64_t>(nodes.size()); ++vertex) {
+            if (FindComponent(component, vertex) == shifted_component) {
+                shifted_potentials[vertex] += delta;
+            }
+        }
+        for (int64_t edge_index = 0; edge_index < static_cast<int64_t>(edges.size()); ++edge_index) {
+            if (get_reduced_cost(edge_index) == 0) {
+                try_add(edge_index);
+            }
+        }
+    }
+
+    assert(basis_edges.size() == (nodes.size() - 1));
+
+    return basis_edges;
+}
+
+
+std::pair<std::vector<int64_t>, std::set<int64_t>>
+GetOptimalFlowCapacityScaling(const std::vector<Edge>& edges,
+                              const std::vector<Node>& nodes,
+                              const std::vector<std::vector<int64_t>>& graph) {
+    std::vector<int64_t> flow;
+    std::vector<int64_t> potentials;
+    CapacityScalingMethod(edges, nodes, graph, flow, potentials);
+    return {flow, GetBasisFromPotentials(edges, nodes, flow, potentials)};
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+
+#include <bits/stdc++.h>
+#include "utility.h"
+
+
+/* Capacity scaling successive shortest paths (Dijkstra on reduced costs). Fills an 
+   optimal flow and optimal potentials in the convention of the network simplex: 
+   cost + potentials[from] - potentials[to] >= 0 on every residual edge. */
+void CapacityScalingMethod(const std::vector<Edge>& edges, 
+                           const std::vector<Node>& nodes, 
+                           const std::vector<std::vector<int64_t>>& graph,
+                           std::vector<int64_t>& flow,
+                           std::vector<int64_t>& potentials);
+
+
+/* Spanning tree of edges tight under the potentials (free edges first). The potentials 
+   must be optimal for the flow and the network connected. Where the tight edges leave 
+   several components, the potentials of one component are shifted (staying optimal) 
+   until a crossing edge becomes tight, so the tree is a dual feasible basis of the flow. */
+std::set<int64_t> GetBasisFromPotentials(const std::vector<Edge>& edges, 
+                                         const std::vector<Node>& nodes, 
+                                         const std::vector<int64_t>& flow,
+                                         const std::vector<int64_t>& potentials);
+
+
+std::pair<std::vector<int64_t>, std::set<int64_t>>
+GetOptimalFlowCapacityScaling(const std::vector<Edge>& edges,
+                              const std::vector<Node>& nodes,
+                              const std::vector<std::vector<int64_t>>& graph);
@@ -0,0 +1,216 @@
+#include "checkpoint.h"
+
+
+const char kCheckpointTag[8] = {'M', 'I', 'L', 'P', 'C', 'K', 'P', 'T'};
+const int64_t kCheckpointVersion = 1;
+
+
+uint64_t GetNetworkFingerprint(const std::vector<Edge>& edges, 
+                               const std::vector<Node>& nodes, 
+                               int64_t volume) {
+    uint64_t fingerprint = 14695981039346656037ull;
+    auto add = [&fingerprint](int64_t value) {
+        for (int64_t i = 0; i < 8; ++i) {
+            fingerprint ^= (static_cast<uint64_t>(value) >> (8 * i)) & 0xff;
+            fingerprint *= 1099511628211ull;
+        }
+    };
+    add(volume);
+    add(static_cast<int64_t>(edges.size()));
+    for (const auto& edge : edges) {
+        add(edge.from);
+        add(edge.to);
+        add(edge.cost);
+        add(edge.low_limit);
+        add(edge.limit);
+    }
+    add(static_cast<int64_t>(nodes.size()));
+    for (const auto& node : nodes) {
+        add(node.vertex);
+        add(node.production);
+    }
+    return fingerprint;
+}
+
+
+void WriteValue(std::ostream& file, int64_t value) {
+    char bytes[8];
+    for (int64_t i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+    file.write(bytes, 8);
+}
+
+
+int64_t ReadValue(std::ifstream& file) {
+    unsigned char bytes[8];
+    if (!file.read(reinterpret_cast<char*>(bytes), 8)) {
+        throw "Checkpoint is truncated.\n";
+    }
+    uint64_t value = 0;
+    for (int64_t i = 0; i < 8; ++i) {
+        value |= uint64_t{bytes[i]} << (8 * i);
+    }
+    return static_cast<int64_t>(value);
+}
+
+
+int64_t ReadEdgeIndex(std::ifstream& file, int64_t edges_count) {
+    int64_t edge_index = ReadValue(file);
+    if (edge_index < 0 || edges_count <= edge_index) {
+        throw "Checkpoint is corrupted.\n";
+    }
+    return edge_index;
+}
+
+
+/* Count of records of at least record_bytes each that still follow in the file. */
+int64_t ReadCount(std::ifstream& file, int64_t file_size, int64_t record_bytes) {
+    int64_t count = ReadValue(file);
+    if (count < 0 || (file_size - static_cast<int64_t>(file.tellg())) / record_bytes < count) {
+        throw "Checkpoint is corrupted.\n";
+    }
+    return count;
+}
+
+
+void WriteCheckpointNode(std::ostream& file, const CheckpointNode& node) {
+    WriteValue(file, node.lower_bound);
+    WriteValue(file, node.depth);
+    WriteValue(file, static_cast<int64_t>(node.bound_changes.size()));
+    for (const auto& change : node.bound_changes) {
+        WriteValue(file, change.edge_index);
+        WriteValue(file, change.low_limit);
+        WriteValue(file, change.limit);
+    }
+}
+
+
+void WriteCheckpoint(const std::string& filename, 
+                     const Checkpoint& checkpoint, 
+                     int64_t frontier_size,
+                     const std::function<void(std::ostream&)>& write_frontier) {
+    std::string temporary_filename = filename + ".tmp";
+    std::ofstream file(temporary_filename, std::ios::binary | std::ios::trunc);
+    file.write(kCheckpointTag, 8);
+    WriteValue(file, kCheckpointVersion);
+    WriteValue(file, static_cast<int64_t>(checkpoint.network_fingerprint));
+    WriteValue(file, static_cast<int64_t>(checkpoint.incumbent_flow.size()));
+
+    for (auto flow : checkpoint.incumbent_flow) {
+        WriteValue(file, flow);
+    }
+    WriteValue(file, checkpoint.incumbent_value);
+
+    WriteValue(file, static_cast<int64_t>(checkpoint.root_basis_edges.size()));
+    for (auto edge_index : checkpoint.root_basis_edges) {
+        WriteValue(file, edge_index);
+    }
+
+    for (const auto& pseudo_cost : checkpoint.pseudo_costs) {
+        WriteValue(file, pseudo_cost.down_gain);
+        WriteValue(file, pseudo_cost.down_count);
+        WriteValue(file, pseudo_cost.up_gain);
+        WriteValue(file, pseudo_cost.up_count);
+    }
+
+    WriteValue(file, checkpoint.nodes_count);
+    WriteValue(file, frontier_size);
+    write_frontier(file);
+
+    file.close();
+    if (!file) {
+        throw "Checkpoint can not be written.\n";
+    }
+    std::filesystem::rename(temporary_filename, filename);
+}
+
+
+Checkpoint ReadCheckpoint(const std::string& filename, 
+                          const std::vector<Edge>& edges, 
+                          const std::vector<Node>& nodes, 
+                          int64_t volume) {
+    int64_t edges_count = static_cast<int64_t>(edges.size());
+    std::ifstream file(filename, std::ios::binary);
+    char tag[8];
+    if (!file.read(tag, 8) || !std::equal(tag, tag + 8, kCheckpointTag)) {
+        throw "Not a checkpoint file.\n";
+    }
+    if (ReadValue(file) != kCheckpointVersion) {
+        throw "Unsupported checkpoint version.\n";
+    }
+    Checkpoint checkpoint;
+    checkpoint.network_fingerprint = static_cast<uint64_t>(ReadValue(file));
+    if (checkpoint.network_fingerprint != GetNetworkFingerprint(edges, nodes, volume) || 
+        ReadValue(file) != edges_count) {
+        throw "Checkpoint was written for another network.\n";
+    }
+    /* The incumbent flow and the pseudo costs take 40 bytes per edge. */
+    int64_t file_size = static_cast<int64_t>(std::filesystem::file_size(filename));
+    if ((file_size - static_cast<int64_t>(file.tellg())) / 40 < edges_count) {
+        throw "Checkpoint is truncated.\n";
+    }
+
+    checkpoint.incumbent_flow.resize(edges_count);
+    for (auto& flow : checkpoint.incumbent_flow) {
+        flow = ReadValue(file);
+    }
+    checkpoint.incumbent_value = ReadValue(file);
+    if (!IsFeasibleFlow(edges, nodes, checkpoint.incumbent_flow)) {
+        throw "Checkpoint incumbent is not a feasible flow.\n";
+    }
+    if (checkpoint.incumbent_value != 
+        GetTargetFunctionValue(edges, checkpoint.incumbent_flow, volume)) {
+        throw "Checkpoint incumbent value does not match its flow.\n";
+    }
+
+    /* The root basis must be a spanning tree: nodes - 1 distinct edges without a cycle. */
+    int64_t basis_size = ReadCount(file, file_size, 8);
+    if (basis_size != static_cast<int64_t>(nodes.size()) - 1) {
+        throw "Checkpoint root basis is not a spanning tree.\n";
+    }
+    std::vector<int64_t> component(nodes.size());
+    std::iota(component.begin(), component.end(), 0);
+    auto find_component = [&component](int64_t vertex) {
+        while (component[vertex] != vertex) {
+            vertex = component[vertex] = component[component[vertex]];
+        }
+        return vertex;
+    };
+    for (int64_t i = 0; i < basis_size; ++i) {
+        int64_t edge_index = ReadEdgeIndex(file, edges_count);
+        int64_t u = find_component(edges[edge_index].from);
+        int64_t v = find_component(edges[edge_index].to);
+        if (u == v) {
+            throw "Checkpoint root basis is not a spanning tree.\n";
+        }
+        component[u] = v;
+        checkpoint.root_basis_edges.insert(edge_index);
+    }
+
+    checkpoint.pseudo_costs.resize(edges_count);
+    for (auto& pseudo_cost : checkpoint.pseudo_costs) {
+        pseudo_cost.down_gain = ReadValue(file);
+        pseudo_cost.down_count = ReadValue(file);
+        pseudo_cost.up_gain = ReadValue(file);
+        pseudo_cost.up_count = ReadValue(file);
+    }
+
+    checkpoint.nodes_count = ReadValue(file);
+    checkpoint.frontier.resize(ReadCount(file, file_size, 24));
+    for (auto& node : checkpoint.frontier) {
+        node.lower_bound = ReadValue(file);
+        node.depth = ReadValue(file);
+        int64_t changes_count = ReadCount(file, file_size, 24);
+        if (edges_count < changes_count) {
+            throw "Checkpoint is corrupted.\n";
+        }
+        node.bound_changes.resize(changes_count);
+        for (auto& change : node.bound_changes) {
+            change.edge_index = ReadEdgeIndex(file, edges_count);
+            change.low_limit = ReadValue(file);
+            change.limit = ReadValue(file);
+        }
+    }
+    return checkpoint;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+
+#include "utility.h"
+#include "node_cache.h"
+#include <bits/stdc++.h>
+
+
+/* Sums of the lower bound gains observed when branching down (flow <= s * volume) and 
+   up (flow >= s * volume + 1) on an edge, and the number of branchings behind them. */
+struct PseudoCost {
+    int64_t down_gain = 0;
+    int64_t down_count = 0;
+    int64_t up_gain = 0;
+    int64_t up_count = 0;
+};
+
+
+/* Open node stored by its bound changes against the root edges. Its LP is solved again 
+   from the root basis when the search gets to it. */
+struct CheckpointNode {
+    int64_t lower_bound;
+    int64_t depth;
+    std::vector<BoundChange> bound_changes;
+};
+
+
+/* Everything BranchAndBound needs to continue a search, and the fingerprint of the 
+   network it searches. The frontier is filled by ReadCheckpoint only: WriteCheckpoint 
+   streams it from the node queue instead. */
+struct Checkpoint {
+    uint64_t network_fingerprint = 0;
+    std::vector<int64_t> incumbent_flow;
+    int64_t incumbent_value = 0;
+    std::set<int64_t> root_basis_edges;
+    std::vector<PseudoCost> pseudo_costs;
+    int64_t nodes_count = 0;
+    std::vector<CheckpointNode> frontier;
+};
+
+
+/* FNV-1a hash of the edges (ends, cost and bounds), the productions and the volume. */
+uint64_t GetNetworkFingerprint(const std::vector<Edge>& edges, 
+                               const std::vector<Node>& nodes, 
+                               int64_t volume);
+
+
+/* Binary file: the "MILPCKPT" tag, the format version, the network fingerprint, the 
+   edges count and then the fields of the checkpoint as little endian 64-bit integers. 
+   It is written to a temporary file first and renamed, so a crash never leaves a 
+   truncated checkpoint. write_frontier writes the frontier_size open nodes with 
+   WriteCheckpointNode. */
+void WriteCheckpoint(const std::string& filename, 
+                     const Checkpoint& checkpoint, 
+                     int64_t frontier_size,
+                     const std::function<void(std::ostream&)>& write_frontier);
+
+
+/* One frontier node in the format of the checkpoint file, for write_frontier: its lower 
+   bound, its depth and its bound changes. */
+void WriteCheckpointNode(std::ostream& file, const CheckpointNode& node);
+
+
+/* Throws if the file is not a checkpoint of this format version, was written for 
+   another network or volume, is corrupted (counts beyond what the file holds, edge 
+   indices out of range, a root basis that is not a spanning tree) or its incumbent is 
+   not a feasible flow of the network with the stored value. */
+Checkpoint ReadCheckpoint(const std::string& filename, 
+                          const std::vector<Edge>& edges, 
+                          const std::vector<Node>& nodes, 
+                          int64_t volume);
@@ -1,4 +1,6 @@
 #include "direct_method.h"
+#include "capacity_scaling.h"
+#include "parallel.h"
 
 
 std::vector<int64_t> GetPotentials(const std::vector<Edge>& edges, 
@@ -44,14 +46,15 @@ std::vector<int64_t> GetPotentials(const std::vector<Edge>& edges,
 }
 
 
-int64_t GetNotOptimalEdgeIndex(const std::vector<Edge>& edges, 
-                               const std::vector<Node>& nodes,
-                               const std::set<int64_t>& basis_edges,
-                               const std::vector<int64_t>& potentials,
-                               const std::vector<int64_t>& flow) {
+/* The not optimal edge with the highest abs eval among edges [begin, end), with its eval. */
+std::pair<int64_t, int64_t> GetNotOptimalEdgeInRange(const std::vector<Edge>& edges, 
+                                                     const std::set<int64_t>& basis_edges,
+                                                     const std::vector<int64_t>& potentials,
+                                                     const std::vector<int64_t>& flow,
+                                                     int64_t begin, int64_t end) {
     int64_t ei_0 = kNoneValue;
     int64_t eval_0 = kNoneValue;
-    for (int64_t edge_index = 0; edge_index < int64_t{edges.size()}; ++edge_index) {
+    for (int64_t edge_index = begin; edge_index < end; ++edge_index) {
         // std::cerr << edge_index << std::endl;
         if (basis_edges.contains(edge_index)) { continue; }
 
@@ -75,7 +78,29 @@ int64_t GetNotOptimalEdgeIndex(const std::vector<Edge>& edges,
             eval_0 = eval;
         }
     }
-    return ei_0;
+    return {ei_0, eval_0};
+}
+
+
+int64_t GetNotOptimalEdgeIndex(const std::vector<Edge>& edges, 
+                               const std::vector<Node>& nodes,
+                               const std::set<int64_t>& basis_edges,
+                               const std::vector<int64_t>& potentials,
+                               const std::vector<int64_t>& flow) {
+    /* Blocks are reduced in order, so ties keep the smallest index as in a serial scan. */
+    using IndexedEval = std::pair<int64_t, int64_t>;
+    IndexedEval none{kNoneValue, kNoneValue};
+
+    return ParallelReduce(static_cast<int64_t>(edges.size()), none, 
+        [&](int64_t begin, int64_t end) {
+            return GetNotOptimalEdgeInRange(edges, basis_edges, potentials, flow, begin, end);
+        },
+        [](IndexedEval lhs, IndexedEval rhs) {
+            if (lhs.first == kNoneValue || (rhs.first != kNoneValue && lhs.second < rhs.second)) {
+                return rhs;
+            }
+            return lhs;
+        }).first;
 }
 
 
@@ -87,13 +112,17 @@ void BuildCycle(const std::vector<Edge>& edges,
     for (auto adjacent_edge_index : graph[vertex]) {
         int64_t next = vertex ^ edges[adjacent_edge_index].from ^ edges[adjacent_edge_index].to;
 
-        if (!basis_edges.contains(adjacent_edge_index) || next == parent) {
+        if (!basis_edges.contains(adjacent_edge_index)) {
             continue;
         }
+        /* Checked before the parent: a basis edge parallel to the entering one closes the cycle. */
         if (next == stop) {
             cycle.emplace_back(adjacent_edge_index, vertex == edges[adjacent_edge_index].from);
             return;
         }
+        if (next == parent) {
+            continue;
+        }
         BuildCycle(edges, graph, next, vertex, stop, basis_edges, cycle);
 
         if (!cycle.empty()) {
@@ -105,11 +134,47 @@ void BuildCycle(const std::vector<Edge>& edges,
 }
 
 
+/* Cunningham's strongly feasible tree rule: the cycle is walked in the direction of 
+   the entering edge starting from its apex (the vertex closest to the root), and 
+   the last blocking edge leaves the basis. Keeps the tree strongly feasible, so 
+   degenerate pivots cannot cycle. */
+int64_t GetLeavingEdgePosition(const std::vector<Edge>& edges,
+                               const std::vector<std::vector<int64_t>>& graph,
+                               const std::set<int64_t>& basis_edges,
+                               int64_t root,
+                               const std::vector<std::pair<int64_t, bool>>& cycle,
+                               const std::vector<int64_t>& thetta,
+                               int64_t min_thetta) {
+    BasisTree tree = GetBasisTree(edges, graph, basis_edges, root);
+
+    int64_t apex_position = 0;
+    int64_t apex_depth = kNoneValue;
+    for (int64_t position = 0; position < static_cast<int64_t>(cycle.size()); ++position) {
+        const auto& [edge_index, is_straight] = cycle[position];
+        int64_t tail = is_straight ? edges[edge_index].from : edges[edge_index].to;
+        if (apex_depth == kNoneValue || tree.depth[tail] < apex_depth) {
+            apex_position = position;
+            apex_depth = tree.depth[tail];
+        }
+    }
+
+    int64_t leaving_position = kNoneValue;
+    for (int64_t step = 0; step < static_cast<int64_t>(cycle.size()); ++step) {
+        int64_t position = (apex_position + step) % static_cast<int64_t>(cycle.size());
+        if (thetta[position] == min_thetta) {
+            leaving_position = position;
+        }
+    }
+    return leaving_position;
+}
+
+
 void Method(const std::vector<Edge>& edges, 
             const std::vector<Node>& nodes, 
             const std::vector<std::vector<int64_t>>& graph,
             std::vector<int64_t>& flow,
-            std::set<int64_t>& basis_edges) {
+            std::set<int64_t>& basis_edges,
+            int64_t root) {
     
     while (true) {
         std::cerr << "iteration" << std::endl;
@@ -153,9 +218,9 @@ void Method(const std::vector<Edge>& edges,
             thetta.push_back(val);
         }
 
-        int64_t index = min_element(thetta.begin(), thetta.end()) - thetta.begin();
+        int64_t min_thetta = *min_element(thetta.begin(), thetta.end());
+        int64_t index = GetLeavingEdgePosition(edges, graph, basis_edges, root, cycle, thetta, min_thetta);
 
-        int64_t min_thetta = thetta[index];
         int64_t min_thetta_edge_index = cycle[index].first;
 
         for (const auto& [edge_index, is_straight] : cycle) {
@@ -174,11 +239,21 @@ void Method(const std::vector<Edge>& edges,
 }
 
 
-std::pair<std::vector<int64_t>, std::set<int64_t>>
-GetInitialFlow(const std::vector<Edge>& edges,
-               const std::vector<Node>& nodes,
-               const std::vector<std::vector<int64_t>>& graph) {
-                   
+/* The network extended by an artificial node joined to every vertex, with the flow and 
+   the basis of the first phase solved on it. */
+struct ArtificialNetwork {
+    std::vector<Edge> edges;
+    std::vector<Node> nodes;
+    std::vector<std::vector<int64_t>> graph;
+    std::vector<int64_t> flow;
+    std::set<int64_t> basis_edges;
+    int64_t artificial_node;
+};
+
+
+ArtificialNetwork SolveFirstPhase(const std::vector<Edge>& edges,
+                                  const std::vector<Node>& nodes,
+                                  const std::vector<std::vector<int64_t>>& graph) {
     /* Building artificial network */
     std::vector<Edge> artificial_edges(edges);
     std::vector<Node> artificial_nodes(nodes);
@@ -188,6 +263,11 @@ GetInitialFlow(const std::vector<Edge>& edges,
 
     for (auto& edge : artificial_edges) { edge.cost = 0; }
 
+    /* Artificial edges get spare capacity so that the initial tree is strongly 
+       feasible with respect to the artificial node. */
+    int64_t artificial_limit = 1;
+    for (auto node : nodes) { artificial_limit += abs(node.production); }
+
     int64_t artificial_node = nodes.size();
     artificial_nodes.push_back(Node{artificial_node, 0});
     artificial_graph.resize(artificial_nodes.size());
@@ -197,9 +277,9 @@ GetInitialFlow(const std::vector<Edge>& edges,
         basis_edges.insert(artificial_edges.size());
 
         if (node.production >= 0) {
-            artificial_edges.push_back(Edge{node.vertex, artificial_node, 1, node.production});
+            artificial_edges.push_back(Edge{node.vertex, artificial_node, 1, artificial_limit});
         } else {
-            artificial_edges.push_back(Edge{artificial_node, node.vertex, 1, abs(node.production)});
+            artificial_edges.push_back(Edge{artificial_node, node.vertex, 1, artificial_limit});
         }
         artificial_flow.push_back(abs(node.production));
     }
@@ -210,7 +290,7 @@ GetInitialFlow(const std::vector<Edge>& edges,
     std::cerr << artificial_edges.size() << std::endl;
 
     /* Solving first phase problem */
-    Method(artificial_edges, artificial_nodes, artificial_graph, artificial_flow, basis_edges);
+    Method(artificial_edges, artificial_nodes, artificial_graph, artificial_flow, basis_edges, artificial_node);
 
     /* Determining initial solution  */
     for (int64_t aei = edges.size(); aei < int64_t{artificial_edges.size()}; ++aei) {
@@ -219,6 +299,18 @@ GetInitialFlow(const std::vector<Edge>& edges,
             throw "No solution can be find.\n";
         }
     }
+
+    return {std::move(artificial_edges), std::move(artificial_nodes), std::move(artificial_graph), 
+            std::move(artificial_flow), std::move(basis_edges), artificial_node};
+}
+
+
+std::pair<std::vector<int64_t>, std::set<int64_t>>
+GetInitialFlow(const std::vector<Edge>& edges,
+               const std::vector<Node>& nodes,
+               const std::vector<std::vector<int64_t>>& graph) {
+    auto [artificial_edges, artificial_nodes, artificial_graph, artificial_flow, basis_edges, artificial_node] = 
+        std::move(SolveFirstPhase(edges, nodes, graph));
     
     //DON'T SURE
     //Добавляем натуральную дугу так, чтобы образовался цикл с двумя искусственными, одну искусственную удаляем
@@ -261,10 +353,32 @@ GetInitialFlow(const std::vector<Edge>& edges,
 }
 
 
+std::pair<std::vector<int64_t>, std::set<int64_t>>
+GetOptimalFlow(const std::vector<Edge>& edges,
+               const std::vector<Node>& nodes,
+               const std::vector<std::vector<int64_t>>& graph) {
+    ArtificialNetwork network = std::move(SolveFirstPhase(edges, nodes, graph));
+
+    /* A flow using an artificial edge costs more than any flow of the network, so the 
+       second phase never puts flow back on them. */
+    int64_t artificial_cost = 1;
+    for (const auto& edge : edges) { artificial_cost += 2 * abs(edge.cost) * edge.limit; }
+    for (int64_t edge_index = 0; edge_index < static_cast<int64_t>(network.edges.size()); ++edge_index) {
+        network.edges[edge_index].cost = edge_index < static_cast<int64_t>(edges.size()) ? 
+                                         edges[edge_index].cost : artificial_cost;
+    }
+    Method(network.edges, network.nodes, network.graph, network.flow, network.basis_edges, network.artificial_node);
+
+    std::vector<int64_t> potentials = std::move(GetPotentials(network.edges, network.nodes, network.basis_edges));
+    potentials.resize(nodes.size());
+    network.flow.resize(edges.size());
+    std::set<int64_t> basis_edges = std::move(GetBasisFromPotentials(edges, nodes, network.flow, potentials));
+    return {std::move(network.flow), std::move(basis_edges)};
+}
+
+
 std::vector<int64_t> Solve(const std::vector<Edge>& edges,
                            const std::vector<Node>& nodes,
                            const std::vector<std::vector<int64_t>>& graph) {
-    auto [flow, basis_edges] = std::move(GetInitialFlow(edges, nodes, graph));
-    Method(edges, nodes, graph, flow, basis_edges);
-    return flow;
+    return GetOptimalFlow(edges, nodes, graph).first;
 }
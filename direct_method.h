@@ -5,19 +5,34 @@
 #include "utility.h"
 
 
+/* Primal network simplex from the flow of basis_edges. The tree must be strongly 
+   feasible with respect to root (a positive amount of flow can be sent from every vertex 
+   to root along the tree path): the leaving edge rule keeps it so, which is what rules 
+   out cycling on degenerate pivots. The tree of GetInitialFlow is not in general. */
 void Method(const std::vector<Edge>& edges, 
             const std::vector<Node>& nodes, 
             const std::vector<std::vector<int64_t>>& graph,
             std::vector<int64_t>& flow,
-            std::set<int64_t>& basis_edges);
+            std::set<int64_t>& basis_edges,
+            int64_t root = 0);
 
 
+/* Feasible flow and its basis after the first phase, the artificial node removed. */
 std::pair<std::vector<int64_t>, std::set<int64_t>>
 GetInitialFlow(const std::vector<Edge>& edges,
                const std::vector<Node>& nodes,
                const std::vector<std::vector<int64_t>>& graph);
 
 
+/* Optimal flow and a dual feasible basis of it. Both phases run on the network extended 
+   by the artificial node, the root of the strongly feasible tree throughout. The network 
+   must be connected. */
+std::pair<std::vector<int64_t>, std::set<int64_t>>
+GetOptimalFlow(const std::vector<Edge>& edges,
+               const std::vector<Node>& nodes,
+               const std::vector<std::vector<int64_t>>& graph);
+
+
 std::vector<int64_t> Solve(const std::vector<Edge>& edges,
                            const std::vector<Node>& nodes,
                            const std::vector<std::vector<int64_t>>& graph);
@@ -1,4 +1,5 @@
 #include "dual_method.h"
+#include "parallel.h"
 
 
 std::vector<int64_t> GetPotentialsDualMethod(const std::vector<Edge>& edges, 
@@ -98,15 +99,17 @@ std::vector<int64_t> GetOptimalOrder(const std::vector<Edge>& edges,
 }
 
 
-std::vector<int64_t> GetPseudoFlow(const std::vector<Edge>& edges, 
-                                   const std::vector<Node>& nodes,
-                                   const std::vector<std::vector<int64_t>>& graph,
-                                   const std::set<int64_t>& basis_edges,
-                                   const std::vector<int64_t>& potentials) {
-    std::vector<int64_t> pseudo_flow(edges.size());
-    std::vector<bool> already_calculated(edges.size(), false);
-
-    for (int64_t edge_index = 0; edge_index < int64_t{edges.size()}; ++edge_index) {
+/* Non-basis edges [begin, end) go to the bound given by the sign of their eval, which 
+   is recorded in at_upper. Returns the number of dually degenerate ones. */
+int64_t SetNonBasisPseudoFlow(const std::vector<Edge>& edges, 
+                              const std::set<int64_t>& basis_edges,
+                              const std::vector<int64_t>& potentials,
+                              std::vector<char>& at_upper,
+                              int64_t begin, int64_t end,
+                              std::vector<int64_t>& pseudo_flow,
+                              std::vector<char>& already_calculated) {
+    int64_t degenerate_edges_cnt = 0;
+    for (int64_t edge_index = begin; edge_index < end; ++edge_index) {
         if (basis_edges.contains(edge_index)) { continue; }
 
         int64_t u = edges[edge_index].from;
@@ -117,18 +120,47 @@ std::vector<int64_t> GetPseudoFlow(const std::vector<Edge>& edges,
         // std::cerr << "eval of (" << edges[edge_index].from + 1 << "->" << edges[edge_index].to + 1 << "): " << eval << std::endl;
 
         if (!eval) {
-            std::cerr << "!!! dual_method.cpp/109/The problem is dually degenerate\n" << std::endl;
-            // throw "The problem is dually degenerate\n";
+            ++degenerate_edges_cnt;
         }
 
-        if (eval <= 0) {
+        /* Dually degenerate edges stay at the bound they were left at. */
+        if (eval != 0) {
+            at_upper[edge_index] = eval > 0;
+        }
+        if (eval < 0 || (eval == 0 && !at_upper[edge_index])) {
             pseudo_flow[edge_index] = edges[edge_index].low_limit;
         }
-        if (eval > 0) {
+        if (eval > 0 || (eval == 0 && at_upper[edge_index])) {
             pseudo_flow[edge_index] = edges[edge_index].limit;
         }
         already_calculated[edge_index] = true;
     }
+    return degenerate_edges_cnt;
+}
+
+
+/* Updates at_upper with the bound every non-degenerate non-basis edge is put at. */
+std::vector<int64_t> GetPseudoFlow(const std::vector<Edge>& edges, 
+                                   const std::vector<Node>& nodes,
+                                   const std::vector<std::vector<int64_t>>& graph,
+                                   const std::set<int64_t>& basis_edges,
+                                   const std::vector<int64_t>& potentials,
+                                   std::vector<char>& at_upper) {
+    std::vector<int64_t> pseudo_flow(edges.size());
+    /* char, not bool: the non-basis edges are filled by blocks running in parallel. */
+    std::vector<char> already_calculated(edges.size(), false);
+
+    int64_t degenerate_edges_cnt = ParallelReduce(static_cast<int64_t>(edges.size()), int64_t{0}, 
+        [&](int64_t begin, int64_t end) {
+            return SetNonBasisPseudoFlow(edges, basis_edges, potentials, at_upper, 
+                                         begin, end, pseudo_flow, already_calculated);
+        }, 
+        std::plus<int64_t>());
+
+    if (degenerate_edges_cnt) {
+        std::cerr << "!!! dual_method.cpp/The problem is dually degenerate on " << degenerate_edges_cnt << " edges" << std::endl;
+        // throw "The problem is dually degenerate\n";
+    }
 
     std::vector<int64_t> order = std::move(GetOptimalOrder(edges, nodes, graph, basis_edges));
 
@@ -203,12 +235,12 @@ void VisitSomeNodes(const std::vector<Edge>& edges,
 
 
 
-void UpdateBasisEdgesSet(const std::vector<Edge>& edges, 
-                         const std::vector<Node>& nodes, 
-                         const std::vector<std::vector<int64_t>>& graph, 
-                         std::set<int64_t>& basis_edges, 
-                         const std::vector<int64_t>& candidates, 
-                         int64_t to_delete) {
+int64_t UpdateBasisEdgesSet(const std::vector<Edge>& edges, 
+                            const std::vector<Node>& nodes, 
+                            const std::vector<std::vector<int64_t>>& graph, 
+                            std::set<int64_t>& basis_edges, 
+                            const std::vector<int64_t>& candidates, 
+                            int64_t to_delete) {
     for (auto candidate : candidates) {
         basis_edges.erase(to_delete);
         basis_edges.insert(candidate);
@@ -225,7 +257,7 @@ void UpdateBasisEdgesSet(const std::vector<Edge>& edges,
         }
 
         if (all_nodes_visited) {
-            return;
+            return candidate;
         } else {
             basis_edges.erase(candidate);
             basis_edges.insert(to_delete);
@@ -239,12 +271,181 @@ void UpdateBasisEdgesSet(const std::vector<Edge>& edges,
 
 
 
+/* Dual ratio test over the non-basis edges [begin, end): the smallest step and the 
+   edges reaching it, in index order. */
+std::pair<int64_t, std::vector<int64_t>> GetRatioTestCandidates(const std::vector<Edge>& edges, 
+                                                                const std::set<int64_t>& basis_edges,
+                                                                const std::vector<int64_t>& potentials,
+                                                                const std::vector<int64_t>& l_values,
+                                                                int64_t begin, int64_t end,
+                                                                const std::vector<char>& at_upper) {
+    int64_t best_step = std::numeric_limits<int64_t>::max();
+    std::vector<int64_t> candidates;
+
+    for (int64_t ei = begin; ei < end; ++ei) {
+        if (basis_edges.contains(ei)) { continue; }
+
+        int64_t u = edges[ei].from;
+        int64_t v = edges[ei].to;
+        int64_t cost = edges[ei].cost;
+        int64_t eval = (potentials[v] - potentials[u]) - cost;
+
+        int64_t p_value = -(l_values[u] - l_values[v]);
+        // std::cerr << "p val " << edges[ei].from + 1 << " " << edges[ei].to + 1 << " " << p_value << std::endl;
+        assert(p_value == -1 || p_value == 1 || p_value == 0);
+
+        bool is_upper = eval > 0 || (eval == 0 && at_upper[ei]);
+
+        /* Degenerate edges (eval == 0) block the step as well: skipping them would 
+           flip them to the other bound and the dual objective could decrease. */
+        int64_t step = std::numeric_limits<int64_t>::max();
+        if ((!is_upper && p_value > 0) || (is_upper && p_value < 0)) {
+            step = abs(eval);
+        }
+
+        if (step < best_step) {
+            best_step = step;
+            candidates.clear();
+            candidates.push_back(ei);
+        } else if (step == best_step) {
+            candidates.push_back(ei);
+        }
+    }
+    return {best_step, candidates};
+}
+
+
+/* Devex and steepest edge keep weights of the basis edges, the other rules do not. */
+bool IsWeightedPricingRule(DualPricingRule pricing_rule) {
+    return pricing_rule == DualPricingRule::kDevex || pricing_rule == DualPricingRule::kSteepestEdge;
+}
+
+
+/* Initial dual pricing weights of the basis edges: the squared norm of the edge's row 
+   of the basis inverse, which on a tree is the number of vertices cut off from the 
+   root by the edge. Devex starts from the same exact weights, since with +-1 tableau 
+   entries unit reference weights would never grow. */
+std::vector<int64_t> GetDualPricingWeights(const std::vector<Edge>& edges, 
+                                           const std::vector<std::vector<int64_t>>& graph,
+                                           const std::set<int64_t>& basis_edges,
+                                           DualPricingRule pricing_rule) {
+    std::vector<int64_t> weights(edges.size(), 1);
+    if (!IsWeightedPricingRule(pricing_rule)) {
+        return weights;
+    }
+
+    BasisTree tree = GetBasisTree(edges, graph, basis_edges, 0);
+    std::vector<int64_t> order(graph.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&tree](int64_t lhs, int64_t rhs) -> bool {
+        return tree.depth[lhs] > tree.depth[rhs];
+    });
+
+    std::vector<int64_t> subtree_size(graph.size(), 1);
+    for (auto vertex : order) {
+        int64_t edge_index = tree.parent_edge[vertex];
+        if (edge_index == kNoneValue) {
+            continue;
+        }
+        int64_t parent = vertex ^ edges[edge_index].from ^ edges[edge_index].to;
+        subtree_size[parent] += subtree_size[vertex];
+        weights[edge_index] = subtree_size[vertex];
+    }
+    return weights;
+}
+
+
+/* Incremental weight update for the pivot (entering, leaving). Only the basis edges on 
+   the cycle closed by the entering edge change, and the cycle is found by climbing the
+   old tree from both ends of the entering edge.
+   Steepest edge: the subtree S cut off by the leaving edge is re-hung on the entering 
+   edge, so edges inside S on the path get |S| - w, edges from the leaving edge up to 
+   the apex lose |S| and edges from the other end up to the apex gain |S|. 
+   Devex: w_i = max(w_i, w_leaving) on the cycle, since every tableau entry is +-1. */
+void UpdateDualPricingWeights(const std::vector<Edge>& edges, 
+                              const BasisTree& tree,
+                              int64_t entering, 
+                              int64_t leaving,
+                              DualPricingRule pricing_rule,
+                              std::vector<int64_t>& weights) {
+    if (!IsWeightedPricingRule(pricing_rule)) {
+        return;
+    }
+
+    int64_t leaving_weight = weights[leaving];
+    std::vector<std::pair<int64_t, int64_t>> path; // (edge index, side of the entering edge)
+    int64_t sides[2] = {edges[entering].from, edges[entering].to};
+    while (sides[0] != sides[1]) {
+        int64_t side = tree.depth[sides[0]] < tree.depth[sides[1]];
+        int64_t edge_index = tree.parent_edge[sides[side]];
+        path.emplace_back(edge_index, side);
+        sides[side] ^= edges[edge_index].from ^ edges[edge_index].to;
+    }
+
+    if (pricing_rule == DualPricingRule::kDevex) {
+        for (const auto& [edge_index, side] : path) {
+            weights[edge_index] = std::max(weights[edge_index], leaving_weight);
+        }
+        weights[entering] = std::max(leaving_weight, int64_t{1});
+        return;
+    }
+
+    int64_t cut_side = kNoneValue;
+    for (const auto& [edge_index, side] : path) {
+        if (edge_index == leaving) {
+            cut_side = side;
+        }
+    }
+    assert(cut_side != kNoneValue);
+
+    bool above_leaving = false;
+    for (const auto& [edge_index, side] : path) {
+        if (side != cut_side) {
+            weights[edge_index] += leaving_weight;
+        } else if (edge_index == leaving) {
+            above_leaving = true;
+        } else if (above_leaving) {
+            weights[edge_index] -= leaving_weight;
+        } else {
+            weights[edge_index] = leaving_weight - weights[edge_index];
+        }
+    }
+    weights[entering] = leaving_weight;
+}
+
+
+/* Priority of a basis edge with bound violation `infeasibility` under the pricing rule. */
+double GetDualPricingScore(const Edge& edge, 
+                           int64_t infeasibility, 
+                           int64_t weight, 
+                           DualPricingRule pricing_rule) {
+    double value = static_cast<double>(infeasibility);
+    switch (pricing_rule) {
+        case DualPricingRule::kLargestInfeasibility:
+            return value;
+        case DualPricingRule::kNormalizedInfeasibility:
+            return value / static_cast<double>(edge.limit - edge.low_limit + 1);
+        case DualPricingRule::kDevex:
+        case DualPricingRule::kSteepestEdge:
+            return value * value / static_cast<double>(weight);
+    }
+    return value;
+}
+
+
 std::vector<int64_t> DualMethod(const std::vector<Edge>& edges, 
                                 const std::vector<Node>& nodes, 
                                 const std::vector<std::vector<int64_t>>& graph,
-                                std::set<int64_t>& basis_edges) {
+                                std::set<int64_t>& basis_edges,
+                                DualPricingRule pricing_rule,
+                                const std::vector<int64_t>& start_flow) {
     std::cerr << "DUAL METHOD STARTS" << std::endl;
     int64_t iterations = 0;
+    std::vector<char> at_upper(edges.size(), false);
+    for (int64_t i = 0; i < static_cast<int64_t>(start_flow.size()); ++i) {
+        at_upper[i] = edges[i].limit <= start_flow[i];
+    }
+    std::vector<int64_t> weights = std::move(GetDualPricingWeights(edges, graph, basis_edges, pricing_rule));
     while (true) {
         ++iterations;
         std::cerr << "iteration: ";
@@ -263,7 +464,7 @@ std::vector<int64_t> DualMethod(const std::vector<Edge>& edges,
         //     std::cerr << pot << " ";
         // }
         // std::cerr << std::endl;
-        auto pseudo_flow = std::move(GetPseudoFlow(edges, nodes, graph, basis_edges, potentials));
+        auto pseudo_flow = std::move(GetPseudoFlow(edges, nodes, graph, basis_edges, potentials, at_upper));
         // std::cerr << "pseudo flow" << std::endl;
         // for (int64_t edge_index = 0; edge_index < edges.size(); ++edge_index) {
         //     std::cerr << edges[edge_index].from + 1 << "->" << edges[edge_index].to + 1 << " pseudo flow is " << pseudo_flow[edge_index] << std::endl;
@@ -271,18 +472,19 @@ std::vector<int64_t> DualMethod(const std::vector<Edge>& edges,
 
 
         int64_t not_optimal_edge_index = kNoneValue;
-        int64_t not_optimal_value = kNoneValue;
+        double not_optimal_value = 0;
         for (auto edge_index : basis_edges) {
-            if (pseudo_flow[edge_index] < edges[edge_index].low_limit && 
-                (not_optimal_edge_index == kNoneValue || not_optimal_value < edges[edge_index].low_limit - pseudo_flow[edge_index])) {
-                not_optimal_edge_index = edge_index;
-                not_optimal_value = edges[edge_index].low_limit - pseudo_flow[edge_index];
+            int64_t infeasibility = std::max(edges[edge_index].low_limit - pseudo_flow[edge_index], 
+                                             pseudo_flow[edge_index] - edges[edge_index].limit);
+            if (infeasibility <= 0) {
+                continue;
             }
-            if (edges[edge_index].limit < pseudo_flow[edge_index] &&
-                (not_optimal_edge_index == kNoneValue || not_optimal_value <  pseudo_flow[edge_index] - edges[edge_index].limit)) {
+
+            double value = GetDualPricingScore(edges[edge_index], infeasibility, weights[edge_index], pricing_rule);
+            if (not_optimal_edge_index == kNoneValue || not_optimal_value < value) {
                 not_optimal_edge_index = edge_index;
-                not_optimal_value = pseudo_flow[edge_index] - edges[edge_index].limit;
-            } 
+                not_optimal_value = value;
+            }
         }
         if (not_optimal_edge_index == kNoneValue) {
             return pseudo_flow;
@@ -306,35 +508,23 @@ std::vector<int64_t> DualMethod(const std::vector<Edge>& edges,
         // }
         // std::cerr << std::endl;
 
-        int64_t best_step = std::numeric_limits<int64_t>::max();
-        std::vector<int64_t> candidates;
-
-        for (int64_t ei = 0; ei < int64_t{edges.size()}; ++ei) {
-            if (basis_edges.contains(ei)) { continue; }
-
-            int64_t u = edges[ei].from;
-            int64_t v = edges[ei].to;
-            int64_t cost = edges[ei].cost;
-            int64_t eval = (potentials[v] - potentials[u]) - cost;
-
-            int64_t p_value = -(l_values[u] - l_values[v]);
-            // std::cerr << "p val " << edges[ei].from + 1 << " " << edges[ei].to + 1 << " " << p_value << std::endl;
-            assert(p_value == -1 || p_value == 1 || p_value == 0);
-
-            int64_t step = std::numeric_limits<int64_t>::max();
-            if (eval * p_value < 0) {
-                step = - (eval / p_value);
-            }
-
-            if (step < best_step) {
-                best_step = step;
-                candidates.clear();
-                candidates.push_back(ei);
-            } else if (step == best_step) {
-                candidates.push_back(ei);
-            }
-        }
-        std::random_shuffle(candidates.begin(), candidates.end());
+        using RatioTest = std::pair<int64_t, std::vector<int64_t>>;
+        auto [best_step, candidates] = ParallelReduce(static_cast<int64_t>(edges.size()), 
+            RatioTest{std::numeric_limits<int64_t>::max(), {}},
+            [&](int64_t begin, int64_t end) {
+                return GetRatioTestCandidates(edges, basis_edges, potentials, l_values, begin, end, at_upper);
+            },
+            [](RatioTest lhs, RatioTest rhs) {
+                if (rhs.first < lhs.first) {
+                    return rhs;
+                }
+                if (rhs.first == lhs.first) {
+                    lhs.second.insert(lhs.second.end(), rhs.second.begin(), rhs.second.end());
+                }
+                return lhs;
+            });
+        /* Ties in the ratio test are broken deterministically by the smallest edge index 
+           (candidates are collected in index order), the same way the leaving edge is. */
         // if (best_step_edge_index == -1) {
         //     throw "asds";
         // }
@@ -348,7 +538,17 @@ std::vector<int64_t> DualMethod(const std::vector<Edge>& edges,
         if (best_step == std::numeric_limits<int64_t>::max()) {
             break;
         }
-        UpdateBasisEdgesSet(edges, nodes, graph, basis_edges, candidates, not_optimal_edge_index);
+        at_upper[not_optimal_edge_index] = edges[not_optimal_edge_index].limit < pseudo_flow[not_optimal_edge_index];
+        /* Only the weighted rules need the tree of the basis before the pivot. */
+        bool weighted_rule = IsWeightedPricingRule(pricing_rule);
+        BasisTree tree;
+        if (weighted_rule) {
+            tree = std::move(GetBasisTree(edges, graph, basis_edges, 0));
+        }
+        int64_t entering_edge_index = UpdateBasisEdgesSet(edges, nodes, graph, basis_edges, candidates, not_optimal_edge_index);
+        if (weighted_rule) {
+            UpdateDualPricingWeights(edges, tree, entering_edge_index, not_optimal_edge_index, pricing_rule, weights);
+        }
         // basis_edges.erase(not_optimal_edge_index);
         // basis_edges.insert(best_step_edge_index);
         // std::cerr << "after" << std::endl;
@@ -364,4 +564,4 @@ std::vector<int64_t> DualMethod(const std::vector<Edge>& edges,
         flow[i] = edges[i].limit;
     }
     return flow;
-}
\ No newline at end of file
+}
\ No newline at end of file
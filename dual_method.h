@@ -5,7 +5,23 @@
 #include "utility.h"
 
 
+/* Rule choosing the leaving basis edge among the ones violating their bounds. */
+enum class DualPricingRule {
+    kLargestInfeasibility,      // largest raw bound violation
+    kNormalizedInfeasibility,   // violation relative to the edge's bound range
+    kDevex,                     // squared violation over Devex reference weights
+    kSteepestEdge,              // squared violation over exact dual steepest-edge weights
+};
+const int64_t kDualPricingRulesCount = 4;
+
+
+/* start_flow (if not empty) is an optimal flow of an earlier basis this one comes from, 
+   such as the engine's root flow or the parent node's. Its non-basis edges at their 
+   upper bound start there, instead of all at the lower one, so dually degenerate edges 
+   keep the side they were optimal at. */
 std::vector<int64_t> DualMethod(const std::vector<Edge>& edges, 
                                 const std::vector<Node>& nodes, 
                                 const std::vector<std::vector<int64_t>>& graph,
-                                std::set<int64_t>& basis_edges);
\ No newline at end of file
+                                std::set<int64_t>& basis_edges,
+                                DualPricingRule pricing_rule = DualPricingRule::kLargestInfeasibility,
+                                const std::vector<int64_t>& start_flow = {});
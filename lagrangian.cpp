@@ -0,0 +1,106 @@
+#include "lagrangian.h"
+
+
+/* Potentials of the basis tree with potentials[v] = potentials[u] + cost on its edges, 
+   the convention of the simplex methods. */
+std::vector<int64_t> GetBasisPotentials(const std::vector<Edge>& edges, 
+                                        const std::vector<std::vector<int64_t>>& graph,
+                                        const std::set<int64_t>& basis_edges) {
+    BasisTree tree = GetBasisTree(edges, graph, basis_edges, 0);
+    std::vector<int64_t> potentials(graph.size());
+    for (auto vertex : tree.order) {
+        int64_t edge_index = tree.parent_edge[vertex];
+        if (edge_index == kNoneValue) {
+            continue;
+        }
+        int64_t parent = vertex ^ edges[edge_index].from ^ edges[edge_index].to;
+        int64_t cost = edges[edge_index].cost;
+        potentials[vertex] = potentials[parent] + (vertex == edges[edge_index].to ? cost : -cost);
+    }
+    return potentials;
+}
+
+
+/* min cost * cars - price * flow over the flows within the edge bounds with cars = 
+   ceil(flow / volume); returns the value and the flow. For a fixed cars count the flow 
+   goes to the end of its range given by the sign of the price, and between the cars 
+   counts whose ranges the bounds cut the value is linear in cars, so the two smallest 
+   and the two largest counts are enough. */
+std::pair<double, int64_t> SolveEdgeSubproblem(const Edge& edge, double price, int64_t volume) {
+    int64_t min_cars = DivideRoundingUp(edge.low_limit, volume);
+    int64_t max_cars = DivideRoundingUp(edge.limit, volume);
+
+    std::pair<double, int64_t> best{std::numeric_limits<double>::infinity(), edge.low_limit};
+    for (int64_t cars : {min_cars, min_cars + 1, max_cars - 1, max_cars}) {
+        if (cars < min_cars || max_cars < cars) {
+            continue;
+        }
+        int64_t low = std::max(edge.low_limit, cars ? (cars - 1) * volume + 1 : 0);
+        int64_t high = std::min(edge.limit, cars * volume);
+        int64_t flow = price > 0 ? high : low;
+        double value = static_cast<double>(edge.cost * cars) - price * static_cast<double>(flow);
+        if (value < best.first) {
+            best = {value, flow};
+        }
+    }
+    return best;
+}
+
+
+int64_t GetLagrangianLowerBound(const std::vector<Edge>& edges, 
+                                const std::vector<Node>& nodes, 
+                                const std::vector<std::vector<int64_t>>& graph,
+                                const std::set<int64_t>& basis_edges,
+                                int64_t volume,
+                                int64_t upper_bound,
+                                int64_t iterations) {
+    /* pi = -potentials / volume prices the basis edges at cost / volume, their LP price. */
+    auto potentials = std::move(GetBasisPotentials(edges, graph, basis_edges));
+    std::vector<double> multipliers(nodes.size());
+    for (int64_t v = 0; v < static_cast<int64_t>(nodes.size()); ++v) {
+        multipliers[v] = -static_cast<double>(potentials[v]) / static_cast<double>(volume);
+    }
+
+    double best_bound = -std::numeric_limits<double>::infinity();
+    double step_scale = 2;
+    int64_t iterations_without_progress = 0;
+    std::vector<double> subgradient(nodes.size());
+    for (int64_t iteration = 0; iteration < iterations; ++iteration) {
+        double bound = 0;
+        for (int64_t v = 0; v < static_cast<int64_t>(nodes.size()); ++v) {
+            bound += multipliers[v] * static_cast<double>(nodes[v].production);
+            subgradient[v] = static_cast<double>(nodes[v].production);
+        }
+        for (const auto& edge : edges) {
+            auto [value, flow] = SolveEdgeSubproblem(edge, multipliers[edge.from] - multipliers[edge.to], volume);
+            bound += value;
+            subgradient[edge.from] -= static_cast<double>(flow);
+            subgradient[edge.to] += static_cast<double>(flow);
+        }
+
+        if (best_bound < bound) {
+            best_bound = bound;
+            iterations_without_progress = 0;
+        } else if (++iterations_without_progress == 5) {
+            step_scale /= 2;
+            iterations_without_progress = 0;
+        }
+
+        /* A zero subgradient means the subproblem flows are conserved: the bound is exact. */
+        double norm = 0;
+        for (auto value : subgradient) {
+            norm += value * value;
+        }
+        if (norm == 0 || static_cast<double>(upper_bound) <= best_bound) {
+            break;
+        }
+
+        double step = step_scale * (static_cast<double>(upper_bound) - bound) / norm;
+        for (int64_t v = 0; v < static_cast<int64_t>(nodes.size()); ++v) {
+            multipliers[v] += step * subgradient[v];
+        }
+    }
+
+    /* The objective is an integer, so the bound rounds up after a margin for rounding errors. */
+    return static_cast<int64_t>(std::ceil(best_bound - 1e-9 * std::max(1.0, std::abs(best_bound))));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+
+#include "utility.h"
+#include <bits/stdc++.h>
+
+
+/* Lower bound of sum cost * ceil(flow / volume) over the flows within the edge bounds, 
+   from the Lagrangian relaxation of flow conservation. With multipliers pi every edge 
+   (u, v) is left with min cost * cars - (pi[u] - pi[v]) * flow over its flow and cars 
+   alone, solved in closed form. The multipliers start from the potentials of the basis 
+   (which make the bound at least the LP one) and take up to iterations subgradient 
+   steps of Polyak size towards upper_bound, stopping early once the bound reaches it. */
+int64_t GetLagrangianLowerBound(const std::vector<Edge>& edges, 
+                                const std::vector<Node>& nodes, 
+                                const std::vector<std::vector<int64_t>>& graph,
+                                const std::set<int64_t>& basis_edges,
+                                int64_t volume,
+                                int64_t upper_bound,
+                                int64_t iterations);
@@ -3,6 +3,7 @@
 #include "direct_method.h"
 #include "dual_method.h"
 #include "branch_and_bound.h"
+#include "parallel.h"
 
 
 int64_t kVolume = 13;
@@ -11,11 +12,16 @@ int64_t kVolume = 13;
 int main(int argc, char** argv) {
     if (argc < 3) {
         std::cerr << "Pass filenames via command line arguments" <<
-                     "(example: ./executable ../edges.txt ../nodes.txt)" << std::endl;
+                     "(example: ./executable ../edges.txt ../nodes.txt [threads])" << std::endl;
         return 0;
     }
     std::string edges_filename = argv[1];
     std::string nodes_filename = argv[2];
+    MILPOptions options;
+    if (argc > 3) {
+        options.threads_count = std::stoll(argv[3]);
+        SetParallelScan(options.threads_count);
+    }
 
     std::vector<Edge> edges;
     std::vector<Node> nodes;
@@ -39,7 +45,8 @@ int main(int argc, char** argv) {
     // return 0;
     
 
-    auto milp_flow = SolveMILP(edges, nodes, graph, kVolume);
+    MILPStatistics statistics;
+    auto milp_flow = SolveMILP(edges, nodes, graph, kVolume, options, &statistics);
     for (int64_t i = 0; i < int64_t{edges.size()}; ++i) {
         std::cerr << "edge: (" << edges[i].from + 1 << " -> " << edges[i].to + 1 << ") " << flow[i] << std::endl;
     }
@@ -51,6 +58,7 @@ int main(int argc, char** argv) {
 
     std::cerr << "Linear program value: " << GetTargetFunctionValue(edges, flow, kVolume) << std::endl;
     std::cerr << "Mixed integer linear program value: " << GetTargetFunctionValue(edges, milp_flow, kVolume) << std::endl;
+    std::cerr << "Proven lower bound: " << statistics.lower_bound << " (" << statistics.nodes_count << " nodes)" << std::endl;
     // auto flow = std::move(Solve(edges, nodes, graph));
 
 
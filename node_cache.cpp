@@ -0,0 +1,98 @@
+#include "node_cache.h"
+
+
+uint64_t GetBoundChangesHash(const std::vector<BoundChange>& bound_changes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto& change : bound_changes) {
+        for (int64_t value : {change.edge_index, change.low_limit, change.limit}) {
+            hash ^= static_cast<uint64_t>(value);
+            hash *= 1099511628211ull;
+            hash ^= hash >> 29;
+        }
+    }
+    return hash;
+}
+
+
+int64_t GetNodeLPBytes(const std::vector<int64_t>& flow, const std::set<int64_t>& basis_edges) {
+    return static_cast<int64_t>(flow.size() * sizeof(int64_t)) + 
+           /* std::set node: the value and three pointers plus the color. */
+           static_cast<int64_t>(basis_edges.size() * 5 * sizeof(int64_t));
+}
+
+
+NodeCache::NodeCache(int64_t memory_budget) 
+    : memory_budget_(memory_budget) {
+}
+
+
+std::vector<BoundChange> GetBoundChanges(const std::vector<Edge>& root_edges, 
+                                         const std::vector<Edge>& edges) {
+    std::vector<BoundChange> bound_changes;
+    for (int64_t i = 0; i < static_cast<int64_t>(edges.size()); ++i) {
+        if (edges[i].low_limit != root_edges[i].low_limit || edges[i].limit != root_edges[i].limit) {
+            bound_changes.push_back({i, edges[i].low_limit, edges[i].limit});
+        }
+    }
+    return bound_changes;
+}
+
+
+std::vector<Edge> ApplyBoundChanges(const std::vector<Edge>& root_edges, 
+                                    const std::vector<BoundChange>& bound_changes) {
+    std::vector<Edge> edges(root_edges);
+    for (const auto& change : bound_changes) {
+        edges[change.edge_index].low_limit = change.low_limit;
+        edges[change.edge_index].limit = change.limit;
+    }
+    return edges;
+}
+
+
+void NodeCache::Erase(std::list<Entry>::iterator entry) {
+    memory_used_ -= entry->bytes;
+    index_.erase(entry->hash);
+    entries_.erase(entry);
+}
+
+
+bool NodeCache::Take(const std::vector<BoundChange>& bound_changes, NodeLP& node) {
+    if (!memory_budget_) {
+        return false;
+    }
+    auto it = index_.find(GetBoundChangesHash(bound_changes));
+    /* Hash collisions are told apart by the stored bound changes themselves. */
+    if (it == index_.end() || it->second->bound_changes != bound_changes) {
+        return false;
+    }
+    ++hits_count_;
+    node = std::move(it->second->node);
+    Erase(it->second);
+    return true;
+}
+
+
+void NodeCache::Insert(const std::vector<BoundChange>& bound_changes, NodeLP node) {
+    if (!memory_budget_) {
+        return;
+    }
+    uint64_t hash = GetBoundChangesHash(bound_changes);
+    int64_t bytes = static_cast<int64_t>(sizeof(Entry)) + 
+                    static_cast<int64_t>(bound_changes.size() * sizeof(BoundChange)) + 
+                    GetNodeLPBytes(node.flow, node.basis_edges);
+    if (bytes > memory_budget_) {
+        return;
+    }
+
+    auto it = index_.find(hash);
+    if (it != index_.end()) {
+        Erase(it->second);
+    }
+    while (memory_used_ + bytes > memory_budget_) {
+        Erase(std::prev(entries_.end()));
+    }
+
+    entries_.push_front({hash, bound_changes, std::move(node), bytes});
+    index_[hash] = entries_.begin();
+    memory_used_ += bytes;
+}
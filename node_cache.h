@@ -0,0 +1,75 @@
+#pragma once
+
+
+#include "utility.h"
+#include <bits/stdc++.h>
+
+
+/* Bounds of one edge that differ from the root problem. */
+struct BoundChange {
+    int64_t edge_index;
+    int64_t low_limit;
+    int64_t limit;
+
+    bool operator==(const BoundChange& other) const = default;
+};
+
+
+/* Bounds of edges that differ from root_edges, in the order of the edges. */
+std::vector<BoundChange> GetBoundChanges(const std::vector<Edge>& root_edges, 
+                                         const std::vector<Edge>& edges);
+
+
+std::vector<Edge> ApplyBoundChanges(const std::vector<Edge>& root_edges, 
+                                    const std::vector<BoundChange>& bound_changes);
+
+
+/* LP of a branch and bound node: the dual method's flow and the basis it stopped at. */
+struct NodeLP {
+    std::vector<int64_t> flow;
+    std::set<int64_t> basis_edges;
+};
+
+
+/* Approximate memory taken by a node's LP, charged alike by the node LP cache and the 
+   node queue so that their budgets measure the same thing. */
+int64_t GetNodeLPBytes(const std::vector<int64_t>& flow, const std::set<int64_t>& basis_edges);
+
+
+/* LPs of the open nodes NodeQueue spills to disk, keyed by their bound changes against 
+   the root edges. A node paged back in takes its LP from here instead of solving it 
+   again from the root basis, which is the only time the table hits: nodes that never 
+   spill are not stored, and a search resumed from a checkpoint starts empty. The 
+   stored entries are bounded by memory_budget bytes and the least recently used ones 
+   are evicted first; memory_budget = 0 disables the table. */
+class NodeCache {
+public:
+    explicit NodeCache(int64_t memory_budget);
+
+    bool IsEnabled() const { return memory_budget_ != 0; }
+
+    /* Moves the LP stored for the bound changes out into node, false on a miss. */
+    bool Take(const std::vector<BoundChange>& bound_changes, NodeLP& node);
+
+    void Insert(const std::vector<BoundChange>& bound_changes, NodeLP node);
+
+    int64_t GetHitsCount() const { return hits_count_; }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::vector<BoundChange> bound_changes;
+        NodeLP node;
+        int64_t bytes;
+    };
+
+    void Erase(std::list<Entry>::iterator entry);
+
+    int64_t memory_budget_;
+    int64_t memory_used_ = 0;
+    int64_t hits_count_ = 0;
+
+    /* Most recently used first. */
+    std::list<Entry> entries_;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
@@ -0,0 +1,279 @@
+#include "node_queue.h"
+
+
+/* Nodes read back from the log at once, as long as they fit in half the budget 
+   (at least one). */
+const int64_t kPageInBatchSize = 1024;
+
+
+uint64_t EncodeZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+
+int64_t DecodeZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+
+void WriteVarint(std::fstream& file, uint64_t value) {
+    while (value >= 0x80) {
+        file.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    file.put(static_cast<char>(value));
+}
+
+
+uint64_t ReadVarint(std::fstream& file) {
+    uint64_t value = 0;
+    for (int64_t shift = 0; shift < 64; shift += 7) {
+        int byte = file.get();
+        if (byte == std::char_traits<char>::eof()) {
+            throw "Node log is truncated.\n";
+        }
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+
+NodeQueue::NodeQueue(const std::vector<Edge>& root_edges, 
+                     const std::set<int64_t>& root_basis_edges,
+                     int64_t memory_budget,
+                     int64_t cache_bytes,
+                     const std::string& spill_directory) 
+    : root_edges_(root_edges), root_basis_edges_(root_basis_edges), memory_budget_(memory_budget), 
+      cache_(cache_bytes) {
+    static std::atomic<int64_t> queues_count = 0;
+    std::filesystem::path directory = spill_directory.empty() ? std::filesystem::temp_directory_path() : 
+                                                                std::filesystem::path(spill_directory);
+    log_filename_ = (directory / ("milp_nodes_" + 
+                                  std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + "_" + 
+                                  std::to_string(queues_count++) + ".log")).string();
+}
+
+
+NodeQueue::~NodeQueue() {
+    if (log_.is_open()) {
+        log_.close();
+        std::filesystem::remove(log_filename_);
+    }
+}
+
+
+std::pair<int64_t, int64_t> NodeQueue::GetPriority(const Entry& entry) {
+    return {entry.node.lower_bound, -entry.node.depth};
+}
+
+
+bool NodeQueue::IsWorseEntry(const Entry& lhs, const Entry& rhs) {
+    return GetPriority(lhs) > GetPriority(rhs);
+}
+
+
+int64_t NodeQueue::GetEntryBytes(const Entry& entry) {
+    return static_cast<int64_t>(sizeof(Entry)) + 
+           static_cast<int64_t>(entry.node.edges.size() * sizeof(Edge)) + 
+           GetNodeLPBytes(entry.node.flow, entry.node.basis_edges) + 
+           static_cast<int64_t>(entry.bound_changes.size() * sizeof(BoundChange));
+}
+
+
+CheckpointNode NodeQueue::GetCompactNode(const Entry& entry) const {
+    return {entry.node.lower_bound, entry.node.depth, 
+            entry.node.edges.empty() ? entry.bound_changes : GetBoundChanges(root_edges_, entry.node.edges)};
+}
+
+
+bool NodeQueue::Empty() const {
+    return heap_.empty() && GetBestRun() == kNoneValue;
+}
+
+
+int64_t NodeQueue::GetBestRun() const {
+    int64_t best_run = kNoneValue;
+    for (int64_t i = 0; i < static_cast<int64_t>(runs_.size()); ++i) {
+        if (runs_[i].remaining_count && 
+            (best_run == kNoneValue || 
+             std::pair(runs_[i].lower_bound, -runs_[i].depth) < std::pair(runs_[best_run].lower_bound, -runs_[best_run].depth))) {
+            best_run = i;
+        }
+    }
+    return best_run;
+}
+
+
+int64_t NodeQueue::GetBestLowerBound() const {
+    int64_t best_run = GetBestRun();
+    if (heap_.empty()) {
+        return runs_[best_run].lower_bound;
+    }
+    int64_t lower_bound = GetPriority(heap_.front()).first;
+    return best_run == kNoneValue ? lower_bound : std::min(lower_bound, runs_[best_run].lower_bound);
+}
+
+
+void NodeQueue::Push(BranchNode node) {
+    PushEntry({std::move(node), {}});
+}
+
+
+void NodeQueue::Push(CheckpointNode node) {
+    PushEntry({BranchNode{{}, {}, {}, node.lower_bound, node.depth}, std::move(node.bound_changes)});
+}
+
+
+void NodeQueue::PushEntry(Entry entry) {
+    memory_used_ += GetEntryBytes(entry);
+    heap_.push_back(std::move(entry));
+    std::push_heap(heap_.begin(), heap_.end(), IsWorseEntry);
+    if (memory_budget_ < memory_used_ && heap_.size() > 1) {
+        Spill();
+    }
+}
+
+
+BranchNode NodeQueue::Pop() {
+    int64_t best_run = GetBestRun();
+    if (best_run != kNoneValue && 
+        (heap_.empty() || std::pair(runs_[best_run].lower_bound, -runs_[best_run].depth) < GetPriority(heap_.front()))) {
+        PageIn(best_run);
+    }
+
+    std::pop_heap(heap_.begin(), heap_.end(), IsWorseEntry);
+    Entry entry = std::move(heap_.back());
+    heap_.pop_back();
+    memory_used_ -= GetEntryBytes(entry);
+
+    if (!entry.node.edges.empty()) {
+        return std::move(entry.node);
+    }
+    NodeLP node_lp;
+    if (!cache_.Take(entry.bound_changes, node_lp)) {
+        node_lp.basis_edges = root_basis_edges_;
+    }
+    return BranchNode{ApplyBoundChanges(root_edges_, entry.bound_changes), std::move(node_lp.basis_edges), 
+                      std::move(node_lp.flow), entry.node.lower_bound, entry.node.depth};
+}
+
+
+void NodeQueue::Spill() {
+    if (!log_.is_open()) {
+        log_.open(log_filename_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!log_) {
+            throw "Node log can not be opened.\n";
+        }
+    }
+
+    /* The better half stays in memory, the rest goes to the log best first. */
+    auto is_better = [](const Entry& lhs, const Entry& rhs) { return IsWorseEntry(rhs, lhs); };
+    auto spilled = heap_.begin() + static_cast<int64_t>(heap_.size()) / 2;
+    std::nth_element(heap_.begin(), spilled, heap_.end(), is_better);
+    std::sort(spilled, heap_.end(), is_better);
+
+    log_.clear();
+    log_.seekp(0, std::ios::end);
+    auto [lower_bound, negative_depth] = GetPriority(*spilled);
+    runs_.push_back({static_cast<int64_t>(log_.tellp()), int64_t{heap_.end() - spilled}, lower_bound, -negative_depth});
+    for (auto it = spilled; it != heap_.end(); ++it) {
+        memory_used_ -= GetEntryBytes(*it);
+        CheckpointNode node = std::move(GetCompactNode(*it));
+        WriteNode(node);
+        if (cache_.IsEnabled() && !it->node.flow.empty()) {
+            cache_.Insert(node.bound_changes, {std::move(it->node.flow), std::move(it->node.basis_edges)});
+        }
+    }
+    spilled_nodes_count_ += int64_t{heap_.end() - spilled};
+    std::cerr << "node queue: spilled " << heap_.end() - spilled << " nodes to " << log_filename_ << std::endl;
+
+    heap_.erase(spilled, heap_.end());
+    std::make_heap(heap_.begin(), heap_.end(), IsWorseEntry);
+}
+
+
+void NodeQueue::PageIn(int64_t run_index) {
+    SpillRun& run = runs_[run_index];
+    log_.clear();
+    log_.seekg(run.offset);
+    for (int64_t i = 0; i < kPageInBatchSize && run.remaining_count && (!i || memory_used_ <= memory_budget_ / 2); ++i) {
+        CheckpointNode node = std::move(ReadNode());
+        --run.remaining_count;
+        Entry entry{BranchNode{{}, {}, {}, node.lower_bound, node.depth}, std::move(node.bound_changes)};
+        memory_used_ += GetEntryBytes(entry);
+        heap_.push_back(std::move(entry));
+        std::push_heap(heap_.begin(), heap_.end(), IsWorseEntry);
+    }
+
+    run.offset = static_cast<int64_t>(log_.tellg());
+    if (run.remaining_count) {
+        run.lower_bound = DecodeZigZag(ReadVarint(log_));
+        run.depth = static_cast<int64_t>(ReadVarint(log_));
+    } else if (GetBestRun() == kNoneValue) {
+        /* Everything was read back, the log starts over. */
+        runs_.clear();
+        log_.close();
+        log_.open(log_filename_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+}
+
+
+int64_t NodeQueue::GetFrontierSize() const {
+    int64_t frontier_size = static_cast<int64_t>(heap_.size());
+    for (const auto& run : runs_) {
+        frontier_size += run.remaining_count;
+    }
+    return frontier_size;
+}
+
+
+void NodeQueue::WriteFrontier(std::ostream& file) {
+    for (const auto& entry : heap_) {
+        WriteCheckpointNode(file, GetCompactNode(entry));
+    }
+    for (const auto& run : runs_) {
+        log_.clear();
+        log_.seekg(run.offset);
+        for (int64_t i = 0; i < run.remaining_count; ++i) {
+            WriteCheckpointNode(file, ReadNode());
+        }
+    }
+}
+
+
+/* Varints of the zigzag coded lower bound, the depth, the number of bound changes and 
+   for each of them the edge index step and the bounds relative to the root edge. */
+void NodeQueue::WriteNode(const CheckpointNode& node) {
+    WriteVarint(log_, EncodeZigZag(node.lower_bound));
+    WriteVarint(log_, static_cast<uint64_t>(node.depth));
+    WriteVarint(log_, node.bound_changes.size());
+    int64_t edge_index = 0;
+    for (const auto& change : node.bound_changes) {
+        WriteVarint(log_, EncodeZigZag(change.edge_index - edge_index));
+        WriteVarint(log_, EncodeZigZag(change.low_limit - root_edges_[change.edge_index].low_limit));
+        WriteVarint(log_, EncodeZigZag(change.limit - root_edges_[change.edge_index].limit));
+        edge_index = change.edge_index;
+    }
+    if (!log_) {
+        throw "Node log can not be written.\n";
+    }
+}
+
+
+CheckpointNode NodeQueue::ReadNode() {
+    CheckpointNode node;
+    node.lower_bound = DecodeZigZag(ReadVarint(log_));
+    node.depth = static_cast<int64_t>(ReadVarint(log_));
+    node.bound_changes.resize(ReadVarint(log_));
+    int64_t edge_index = 0;
+    for (auto& change : node.bound_changes) {
+        edge_index += DecodeZigZag(ReadVarint(log_));
+        change.edge_index = edge_index;
+        change.low_limit = root_edges_[edge_index].low_limit + DecodeZigZag(ReadVarint(log_));
+        change.limit = root_edges_[edge_index].limit + DecodeZigZag(ReadVarint(log_));
+    }
+    return node;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+
+#include "utility.h"
+#include "node_cache.h"
+#include "checkpoint.h"
+#include <bits/stdc++.h>
+
+
+/* Open node of the search: its bounds, the LP solved on them and the bound it gives. 
+   Nodes restored from a checkpoint or from disk have no flow yet. */
+struct BranchNode {
+    std::vector<Edge> edges;
+    std::set<int64_t> basis_edges;
+    std::vector<int64_t> flow;
+    int64_t lower_bound = 0;
+    int64_t depth = 0;
+};
+
+
+/* Best bound first queue of open nodes, the deeper node on ties so that the search 
+   dives while it can. 
+   Its nodes are charged by their approximate size against memory_budget bytes. When 
+   they exceed it, the worse half of the nodes in memory is compressed to its bound 
+   changes against the root edges and appended to a log file in spill_directory as one 
+   run sorted best first. The runs are read back in batches once they hold the best 
+   bound or the nodes in memory run out; such nodes lose their LP and are solved again 
+   from the root basis, unless the LP cache of cache_bytes still holds it. The log file 
+   is removed with the queue. */
+class NodeQueue {
+public:
+    NodeQueue(const std::vector<Edge>& root_edges, 
+              const std::set<int64_t>& root_basis_edges,
+              int64_t memory_budget,
+              int64_t cache_bytes,
+              const std::string& spill_directory);
+    ~NodeQueue();
+
+    bool Empty() const;
+    /* The smallest lower bound of the open nodes, the queue must not be empty. */
+    int64_t GetBestLowerBound() const;
+
+    void Push(BranchNode node);
+    void Push(CheckpointNode node);
+    BranchNode Pop();
+
+    /* Number of open nodes, the spilled ones included. */
+    int64_t GetFrontierSize() const;
+    /* Writes all open nodes to a checkpoint by their bound changes, the spilled ones 
+       copied from the log one at a time. */
+    void WriteFrontier(std::ostream& file);
+
+    int64_t GetSpilledNodesCount() const { return spilled_nodes_count_; }
+    /* Spilled nodes that got their LP back from the cache. */
+    int64_t GetRestoredNodesCount() const { return cache_.GetHitsCount(); }
+
+private:
+    /* Node in memory, compact (only its bound changes) if it has no edges. */
+    struct Entry {
+        BranchNode node;
+        std::vector<BoundChange> bound_changes;
+    };
+
+    /* Part of the log written at once: where its next unread node starts, how many 
+       are left and the priority of the next one. */
+    struct SpillRun {
+        int64_t offset;
+        int64_t remaining_count;
+        int64_t lower_bound;
+        int64_t depth;
+    };
+
+    static std::pair<int64_t, int64_t> GetPriority(const Entry& entry);
+    static bool IsWorseEntry(const Entry& lhs, const Entry& rhs);
+    static int64_t GetEntryBytes(const Entry& entry);
+    CheckpointNode GetCompactNode(const Entry& entry) const;
+
+    void PushEntry(Entry entry);
+    void Spill();
+    void PageIn(int64_t run_index);
+    /* The run holding the best spilled node or kNoneValue. */
+    int64_t GetBestRun() const;
+
+    void WriteNode(const CheckpointNode& node);
+    CheckpointNode ReadNode();
+
+    const std::vector<Edge>& root_edges_;
+    const std::set<int64_t>& root_basis_edges_;
+    int64_t memory_budget_;
+    int64_t memory_used_ = 0;
+
+    std::vector<Entry> heap_;
+
+    std::string log_filename_;
+    std::fstream log_;
+    std::vector<SpillRun> runs_;
+    int64_t spilled_nodes_count_ = 0;
+    NodeCache cache_;
+};
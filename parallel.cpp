@@ -0,0 +1,116 @@
+#include "parallel.h"
+
+
+class ThreadPool {
+public:
+    explicit ThreadPool(int64_t workers_count) {
+        for (int64_t i = 0; i < workers_count; ++i) {
+            workers_.emplace_back([this] { 
+                while (RunTask(true)) {} 
+            });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+    /* Runs one queued task. Workers wait for one, callers only help with what is queued. */
+    bool RunTask(bool wait) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wait) {
+                condition_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+            }
+            if (tasks_.empty()) {
+                return false;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+        return true;
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopped_ = false;
+};
+
+
+static std::unique_ptr<ThreadPool> scan_pool;
+static int64_t scan_threads_count = 1;
+static int64_t scan_min_block_size = int64_t{1} << 14;
+/* Scans running on the pool, so that reconfiguring under a running solve fails loudly instead of 
+   destroying the pool a scan is waiting on. */
+static std::atomic<int64_t> running_scans_count = 0;
+
+
+void SetParallelScan(int64_t threads_count, int64_t min_block_size) {
+    if (running_scans_count != 0) {
+        throw "SetParallelScan called while a scan is running.\n";
+    }
+    scan_pool.reset();
+    scan_threads_count = std::max(threads_count, int64_t{1});
+    scan_min_block_size = std::max(min_block_size, int64_t{1});
+    if (scan_threads_count > 1) {
+        scan_pool = std::make_unique<ThreadPool>(scan_threads_count - 1);
+    }
+}
+
+
+int64_t GetScanBlocksCount(int64_t size) {
+    return std::max(std::min(scan_threads_count, size / scan_min_block_size), int64_t{1});
+}
+
+
+void ParallelFor(int64_t size, const std::function<void(int64_t, int64_t, int64_t)>& body) {
+    int64_t blocks_count = GetScanBlocksCount(size);
+    if (blocks_count == 1 || !scan_pool) {
+        body(0, 0, size);
+        return;
+    }
+
+    ++running_scans_count;
+    std::mutex mutex;
+    std::condition_variable condition;
+    int64_t pending = blocks_count - 1;
+
+    for (int64_t block = 1; block < blocks_count; ++block) {
+        scan_pool->Submit([&, block] {
+            body(block, size * block / blocks_count, size * (block + 1) / blocks_count);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                condition.notify_one();
+            }
+        });
+    }
+    body(0, 0, size / blocks_count);
+
+    /* Helping with queued blocks instead of sleeping keeps concurrent callers from starving. */
+    while (scan_pool->RunTask(false)) {}
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&pending] { return pending == 0; });
+    --running_scans_count;
+}
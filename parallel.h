@@ -0,0 +1,36 @@
+#pragma once
+
+
+#include <bits/stdc++.h>
+
+
+/* Optional thread pool for the scans over all edges (pricing, pseudo flow, ratio test).
+   Scans shorter than threads_count * min_block_size are split into fewer blocks, and a 
+   scan with a single block runs on the calling thread. threads_count = 1 (the default) 
+   keeps everything single-threaded. The settings are process-wide: call it before 
+   solving, never while a solve runs (it throws if it catches a scan in progress). */
+void SetParallelScan(int64_t threads_count, int64_t min_block_size = int64_t{1} << 14);
+
+
+int64_t GetScanBlocksCount(int64_t size);
+
+
+/* Runs body(block, begin, end) over the blocks of [0, size) and waits for all of them. */
+void ParallelFor(int64_t size, const std::function<void(int64_t, int64_t, int64_t)>& body);
+
+
+/* Per-block partial results combined in block order, so the result does not depend on 
+   the number of threads as long as reduce is associative. */
+template <typename T, typename Block, typename Reduce>
+T ParallelReduce(int64_t size, const T& identity, Block block, Reduce reduce) {
+    std::vector<T> partial(GetScanBlocksCount(size), identity);
+    ParallelFor(size, [&](int64_t index, int64_t begin, int64_t end) {
+        partial[index] = block(begin, end);
+    });
+
+    T result = identity;
+    for (auto& value : partial) {
+        result = reduce(std::move(result), std::move(value));
+    }
+    return result;
+}
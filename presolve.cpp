@@ -0,0 +1,172 @@
+#include "presolve.h"
+
+
+std::vector<Subproblem> SplitIntoComponents(const std::vector<Edge>& edges, 
+                                            const std::vector<Node>& nodes, 
+                                            const std::vector<std::vector<int64_t>>& graph) {
+    std::vector<int64_t> component(graph.size(), kNoneValue);
+    std::vector<int64_t> local_index(graph.size(), kNoneValue);
+    std::vector<Subproblem> subproblems;
+
+    for (int64_t start = 0; start < static_cast<int64_t>(graph.size()); ++start) {
+        if (component[start] != kNoneValue) {
+            continue;
+        }
+        if (graph[start].empty() && nodes[start].production == 0) {
+            continue;
+        }
+
+        int64_t index = static_cast<int64_t>(subproblems.size());
+        Subproblem& subproblem = subproblems.emplace_back();
+        int64_t balance = 0;
+
+        std::queue<int64_t> queue;
+        component[start] = index;
+        queue.push(start);
+        while (!queue.empty()) {
+            int64_t vertex = queue.front();
+            queue.pop();
+
+            local_index[vertex] = static_cast<int64_t>(subproblem.vertices.size());
+            subproblem.vertices.push_back(vertex);
+            balance += nodes[vertex].production;
+
+            for (auto edge_index : graph[vertex]) {
+                int64_t next = vertex ^ edges[edge_index].from ^ edges[edge_index].to;
+                if (component[next] == kNoneValue) {
+                    component[next] = index;
+                    queue.push(next);
+                }
+            }
+        }
+
+        if (balance != 0) {
+            throw "No solution can be find.\n";
+        }
+    }
+
+    for (int64_t i = 0; i < static_cast<int64_t>(edges.size()); ++i) {
+        Subproblem& subproblem = subproblems[component[edges[i].from]];
+        Edge edge = edges[i];
+        edge.from = local_index[edge.from];
+        edge.to = local_index[edge.to];
+        subproblem.edge_indices.push_back(i);
+        subproblem.edges.push_back(edge);
+    }
+
+    for (auto& subproblem : subproblems) {
+        subproblem.graph.resize(subproblem.vertices.size());
+        for (int64_t i = 0; i < static_cast<int64_t>(subproblem.edges.size()); ++i) {
+            subproblem.graph[subproblem.edges[i].from].push_back(i);
+            subproblem.graph[subproblem.edges[i].to].push_back(i);
+        }
+        for (int64_t v = 0; v < static_cast<int64_t>(subproblem.vertices.size()); ++v) {
+            subproblem.nodes.push_back(Node{v, nodes[subproblem.vertices[v]].production});
+        }
+    }
+
+    std::stable_sort(subproblems.begin(), subproblems.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.edges.size() > rhs.edges.size();
+    });
+    return subproblems;
+}
+
+
+std::vector<int64_t> GetVertexOrder(const std::vector<Edge>& edges, 
+                                    const std::vector<std::vector<int64_t>>& graph,
+                                    GraphOrder order) {
+    std::vector<int64_t> vertices;
+    if (order == GraphOrder::kInput) {
+        vertices.resize(graph.size());
+        std::iota(vertices.begin(), vertices.end(), int64_t{0});
+        return vertices;
+    }
+
+    std::vector<int64_t> starts(graph.size());
+    std::iota(starts.begin(), starts.end(), int64_t{0});
+    if (order == GraphOrder::kReverseCuthillMcKee) {
+        std::stable_sort(starts.begin(), starts.end(), [&graph](int64_t lhs, int64_t rhs) {
+            return graph[lhs].size() < graph[rhs].size();
+        });
+    }
+
+    std::vector<char> visited(graph.size(), false);
+    std::vector<int64_t> neighbours;
+    for (auto start : starts) {
+        if (visited[start]) {
+            continue;
+        }
+        visited[start] = true;
+        vertices.push_back(start);
+        /* vertices doubles as the BFS queue. */
+        int64_t head = static_cast<int64_t>(vertices.size()) - 1;
+        for (; head < static_cast<int64_t>(vertices.size()); ++head) {
+            int64_t vertex = vertices[head];
+            neighbours.clear();
+            for (auto edge_index : graph[vertex]) {
+                int64_t next = vertex ^ edges[edge_index].from ^ edges[edge_index].to;
+                if (!visited[next]) {
+                    visited[next] = true;
+                    neighbours.push_back(next);
+                }
+            }
+            if (order == GraphOrder::kReverseCuthillMcKee) {
+                std::stable_sort(neighbours.begin(), neighbours.end(), [&graph](int64_t lhs, int64_t rhs) {
+                    return graph[lhs].size() < graph[rhs].size();
+                });
+            }
+            vertices.insert(vertices.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+
+    if (order == GraphOrder::kReverseCuthillMcKee) {
+        std::reverse(vertices.begin(), vertices.end());
+    }
+    return vertices;
+}
+
+
+Subproblem ReorderGraph(const std::vector<Edge>& edges, 
+                        const std::vector<Node>& nodes, 
+                        const std::vector<std::vector<int64_t>>& graph,
+                        GraphOrder order) {
+    Subproblem reordered;
+    reordered.vertices = std::move(GetVertexOrder(edges, graph, order));
+
+    std::vector<int64_t> new_index(graph.size());
+    for (int64_t v = 0; v < static_cast<int64_t>(reordered.vertices.size()); ++v) {
+        new_index[reordered.vertices[v]] = v;
+        reordered.nodes.push_back(Node{v, nodes[reordered.vertices[v]].production});
+    }
+
+    reordered.edge_indices.resize(edges.size());
+    std::iota(reordered.edge_indices.begin(), reordered.edge_indices.end(), int64_t{0});
+    std::stable_sort(reordered.edge_indices.begin(), reordered.edge_indices.end(), [&](int64_t lhs, int64_t rhs) {
+        return std::pair(new_index[edges[lhs].from], new_index[edges[lhs].to]) < 
+               std::pair(new_index[edges[rhs].from], new_index[edges[rhs].to]);
+    });
+
+    reordered.graph.resize(graph.size());
+    for (auto edge_index : reordered.edge_indices) {
+        Edge edge = edges[edge_index];
+        edge.from = new_index[edge.from];
+        edge.to = new_index[edge.to];
+        reordered.graph[edge.from].push_back(static_cast<int64_t>(reordered.edges.size()));
+        reordered.graph[edge.to].push_back(static_cast<int64_t>(reordered.edges.size()));
+        reordered.edges.push_back(edge);
+    }
+    return reordered;
+}
+
+
+std::vector<int64_t> MergeFlows(const std::vector<Subproblem>& subproblems, 
+                                const std::vector<std::vector<int64_t>>& flows,
+                                int64_t edges_count) {
+    std::vector<int64_t> flow(edges_count);
+    for (int64_t i = 0; i < static_cast<int64_t>(subproblems.size()); ++i) {
+        for (int64_t j = 0; j < static_cast<int64_t>(subproblems[i].edge_indices.size()); ++j) {
+            flow[subproblems[i].edge_indices[j]] = flows[i][j];
+        }
+    }
+    return flow;
+}
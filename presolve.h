@@ -0,0 +1,49 @@
+#pragma once
+
+
+#include "utility.h"
+#include <bits/stdc++.h>
+
+
+/* Part of the network solved on its own. Vertices are renumbered from 0, 
+   edge_indices[i] and vertices[v] map the edges and vertices back to the full network. */
+struct Subproblem {
+    std::vector<Edge> edges;
+    std::vector<Node> nodes;
+    std::vector<std::vector<int64_t>> graph;
+
+    std::vector<int64_t> edge_indices;
+    std::vector<int64_t> vertices;
+};
+
+
+/* Splits the network into its connected components, largest (by edges) first. Vertices 
+   without edges and production are dropped. Throws if a component is not balanced, 
+   since then no flow exists. */
+std::vector<Subproblem> SplitIntoComponents(const std::vector<Edge>& edges, 
+                                            const std::vector<Node>& nodes, 
+                                            const std::vector<std::vector<int64_t>>& graph);
+
+
+/* Vertex order used to relabel the network for cache locality: neighbouring vertices 
+   get close ids, and edges are sorted by their relabeled ends, so scans over the edges 
+   touch the potentials and adjacency lists nearly sequentially. */
+enum class GraphOrder {
+    kInput,                  // ids as read from the input files
+    kBreadthFirst,           // BFS from vertex 0
+    kReverseCuthillMcKee,    // BFS from a low degree vertex, neighbours by degree, reversed
+};
+
+
+/* The whole network relabeled in the given order, as a single subproblem whose 
+   edge_indices and vertices map it back. */
+Subproblem ReorderGraph(const std::vector<Edge>& edges, 
+                        const std::vector<Node>& nodes, 
+                        const std::vector<std::vector<int64_t>>& graph,
+                        GraphOrder order);
+
+
+/* Scatters the flows of the subproblems back to the edges of the full network. */
+std::vector<int64_t> MergeFlows(const std::vector<Subproblem>& subproblems, 
+                                const std::vector<std::vector<int64_t>>& flows,
+                                int64_t edges_count);
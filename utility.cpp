@@ -29,6 +29,9 @@ void ReadGraph(const std::string& edges_filename,
     nodes_file >> nodes_records_count;
 
     nodes->resize(graph->size());
+    for (int64_t i = 0; i < static_cast<int64_t>(nodes->size()); ++i) {
+        (*nodes)[i] = Node{i, 0};
+    }
     for (int64_t i = 0; i < nodes_records_count; ++i) {
         int64_t vertex, production;
         nodes_file >> vertex >> production;
@@ -40,4 +43,69 @@ void ReadGraph(const std::string& edges_filename,
         (*nodes)[vertex] = Node{vertex, production};
     }
     nodes_file.close();
-}
\ No newline at end of file
+}
+
+BasisTree GetBasisTree(const std::vector<Edge>& edges,
+                       const std::vector<std::vector<int64_t>>& graph,
+                       const std::set<int64_t>& basis_edges,
+                       int64_t root) {
+    BasisTree tree{std::vector<int64_t>(graph.size(), kNoneValue), 
+                   std::vector<int64_t>(graph.size(), kNoneValue)};
+    
+    std::queue<int64_t> queue;
+    tree.depth[root] = 0;
+    queue.push(root);
+    while (!queue.empty()) {
+        int64_t vertex = queue.front();
+        queue.pop();
+        tree.order.push_back(vertex);
+
+        for (auto edge_index : graph[vertex]) {
+            int64_t next = vertex ^ edges[edge_index].from ^ edges[edge_index].to;
+            if (!basis_edges.contains(edge_index) || tree.depth[next] != kNoneValue) {
+                continue;
+            }
+            tree.parent_edge[next] = edge_index;
+            tree.depth[next] = tree.depth[vertex] + 1;
+            queue.push(next);
+        }
+    }
+    return tree;
+}
+
+bool IsFeasibleFlow(const std::vector<Edge>& edges,
+                    const std::vector<Node>& nodes,
+                    const std::vector<int64_t>& flow) {
+    std::vector<int64_t> balance(nodes.size());
+    for (int64_t i = 0; i < static_cast<int64_t>(edges.size()); ++i) {
+        if (flow[i] < edges[i].low_limit || edges[i].limit < flow[i]) {
+            return false;
+        }
+        balance[edges[i].from] += flow[i];
+        balance[edges[i].to] -= flow[i];
+    }
+    for (int64_t v = 0; v < static_cast<int64_t>(nodes.size()); ++v) {
+        if (balance[v] != nodes[v].production) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int64_t DivideRoundingUp(int64_t value, int64_t divisor) {
+    return value / divisor + (value % divisor > 0);
+}
+
+
+int64_t GetTargetFunctionValue(const std::vector<Edge>& edges,
+                               const std::vector<int64_t>& flow, 
+                               int64_t volume) {
+    int64_t value = 0;
+    for (int64_t i = 0; i < static_cast<int64_t>(edges.size()); ++i) {
+        int64_t cost = edges[i].cost;
+        int64_t cars = (flow[i] + volume - 1) / volume;
+        value += cost * cars; 
+    }
+    return value;
+}
@@ -28,3 +28,35 @@ void ReadGraph(const std::string& edges_filename,
                std::vector<Edge>* edges, 
                std::vector<Node>* nodes, 
                std::vector<std::vector<int64_t>>* graph);
+
+
+/* Basis spanning tree hanging from `root`: for every vertex the basis edge 
+   leading to its parent (kNoneValue for the root) and its distance to the root, 
+   and the vertices in breadth-first order (every parent before its children). */
+struct BasisTree {
+    std::vector<int64_t> parent_edge;
+    std::vector<int64_t> depth;
+    std::vector<int64_t> order;
+};
+
+
+BasisTree GetBasisTree(const std::vector<Edge>& edges,
+                       const std::vector<std::vector<int64_t>>& graph,
+                       const std::set<int64_t>& basis_edges,
+                       int64_t root);
+
+
+/* Whether flow respects the edge bounds and the production of every node. */
+bool IsFeasibleFlow(const std::vector<Edge>& edges,
+                    const std::vector<Node>& nodes,
+                    const std::vector<int64_t>& flow);
+
+
+/* ceil(value / divisor) for a positive divisor. */
+int64_t DivideRoundingUp(int64_t value, int64_t divisor);
+
+
+/* Cost of the cars carrying the flow: every edge needs ceil(flow / volume) of them. */
+int64_t GetTargetFunctionValue(const std::vector<Edge>& edges,
+                               const std::vector<int64_t>& flow, 
+                               int64_t volume);